@@ -2,6 +2,8 @@
 
 #undef HAVE_LIBPNG
 #undef HAVE_LIBTIFF
+#undef HAVE_EGL
+#undef HAVE_OSMESA
 
 #undef LIGHTSPEED_VERSION_MAJOR
 #undef LIGHTSPEED_VERSION_MINOR
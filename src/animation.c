@@ -89,12 +89,37 @@ update( int message )
 
 	/* Do pending redraws (if any) ONLY if event queue is empty */
 	if (gtk_events_pending( ) == 0) {
+		/* In split view, the cameras share a viewport (and a buffer
+		 * swap), so one redraw means redrawing them all */
+		if (split_view) {
+			for (i = 0; i < num_cams; i++)
+				if (usr_cams[i]->redraw)
+					break;
+			if (i < num_cams)
+				for (i = 0; i < num_cams; i++)
+					usr_cams[i]->redraw = TRUE;
+		}
 		for (i = 0; i < num_cams; i++)
-			if (usr_cams[i]->redraw) {
+			if (usr_cams[i]->redraw)
 				camera_calc_xyz( CAM_POSITION, usr_cams[i] );
-				ogl_draw( i );
+		/* Warp the views to be redrawn together (each ogl_draw( )
+		 * then finds its camera's view up to date) */
+		profile( PROFILE_WARP_BEGIN );
+		warp( WARP_DISTORT_CAMERAS, NULL );
+		profile( PROFILE_WARP_DONE );
+		if (split_view) {
+			if (usr_cams[0]->redraw) {
+				ogl_draw_split( );
 				redraw_occurred = TRUE;
 			}
+		}
+		else {
+			for (i = 0; i < num_cams; i++)
+				if (usr_cams[i]->redraw) {
+					ogl_draw( i );
+					redraw_occurred = TRUE;
+				}
+		}
 
 #if VELOCITY_SLIDER
 		/* Update velocity slider */
@@ -104,6 +129,11 @@ update( int message )
 	else
 		redraw_deferred = TRUE;
 
+	/* Views warped ahead during the redraws need another one */
+	for (i = 0; i < num_cams; i++)
+		if (usr_cams[i]->redraw)
+			redraw_deferred = TRUE;
+
 	/* Semi-BUG: Framerate goes artificially high if only spawned cameras are moved
 	 * (remember that moving the primary camera updates *all* views) */
 	if (redraw_occurred)
@@ -247,6 +277,11 @@ profile( int message )
 		p = 100.0 * ogldraw_total_t / active_total_t;
 		printf( "OpenGL draw: %.3f sec (%.2f%%)\n", ogldraw_total_t, p );
 		printf( "Framerate..: %.3f fps\n", framerate );
+		ogl_show_upload_stats( );
+		printf( "Warp threads: %d\n", warp_pool_get_num_threads( ) );
+		printf( "Warp pipeline depth: %d\n", warp( QUERY, MESG_(WARP_PIPELINE_DEPTH) ) );
+		/* Time the warp kernels */
+		warp( WARP_BENCHMARK, NULL );
 		printf( "=====================================\n" );
 		fflush( stdout );
 		break;
@@ -28,9 +28,21 @@
 
 /* Forward declarations */
 static void draw_coord_axes( float percent, point *cam_pos );
+static void build_coord_axes( float percent );
 static void draw_floating_grid( float percent );
-static void draw_floating_grid_AUX( float unit_size, int i_min, int i_max, int j_min, int j_max, float vis, float side );
+static void draw_floating_grid_AUX( float vis );
+static void build_floating_grid( void );
 static void draw_bounding_box( float percent );
+static void build_bounding_box( float percent );
+
+
+/* Geometry of the auxiliary objects. Animation (fading, rotation, and
+ * the like) goes by GL color and matrix state, so this only needs
+ * rebuilding when the vehicle's extents or an object's deployment
+ * percentage changes */
+static aux_cache axes_cache;
+static aux_cache grid_cache;
+static aux_cache bbox_cache;
 
 
 /* Auxiliary objects control */
@@ -84,6 +96,10 @@ auxiliary_objects( int message1, int message2 )
 	}
 
 	glDisable( GL_LIGHTING );
+	/* (vertices only, the colors are set for each draw) */
+	glEnableClientState( GL_VERTEX_ARRAY );
+	glDisableClientState( GL_NORMAL_ARRAY );
+	glDisableClientState( GL_COLOR_ARRAY );
 
 	if (percent_axes != 0.0)
 		draw_coord_axes( percent_axes, &cam->pos );
@@ -94,23 +110,162 @@ auxiliary_objects( int message1, int message2 )
 	if (percent_grid != 0.0)
 		draw_floating_grid( percent_grid );
 
+#ifdef WITH_BUFFER_OBJECTS
+	if (ogl_buffer_objects( ))
+		glBindBuffer( GL_ARRAY_BUFFER, 0 );
+#endif
+	glDisableClientState( GL_VERTEX_ARRAY );
 	glEnable( GL_LIGHTING );
 }
 
 
+/* Returns TRUE if a cache needs to be (re)built for the current vehicle
+ * extents and the given deployment percentage, emptying it if so */
+static int
+cache_stale( aux_cache *cache, float percent )
+{
+	if (cache->built && (cache->percent == percent) && !memcmp( &cache->exts, &vehicle_extents, sizeof(extents) ))
+		return FALSE;
+
+	cache->exts = vehicle_extents;
+	cache->percent = percent;
+	cache->built = TRUE;
+	cache->num_vertices = 0;
+	cache->buf_stale = TRUE;
+
+	return TRUE;
+}
+
+
+/* Adds a vertex to a cache being built */
+static void
+cache_vertex( aux_cache *cache, float x, float y, float z )
+{
+	float *v;
+
+	if (cache->num_vertices == cache->max_vertices) {
+		cache->max_vertices = MAX(64, 2 * cache->max_vertices);
+		cache->vertices = xrealloc( cache->vertices, 3 * cache->max_vertices * sizeof(float) );
+	}
+	v = &cache->vertices[3 * cache->num_vertices];
+	v[0] = x;
+	v[1] = y;
+	v[2] = z;
+	++cache->num_vertices;
+}
+
+
+/* Makes a cache's vertices the GL's vertex array: from its buffer object,
+ * uploaded to only after a rebuild, or else straight from memory */
+static void
+cache_bind( aux_cache *cache )
+{
+	const float *pointer;
+
+	pointer = cache->vertices;
+#ifdef WITH_BUFFER_OBJECTS
+	if (ogl_buffer_objects( )) {
+		if (cache->buf == 0) {
+			glGenBuffers( 1, &cache->buf );
+			cache->buf_stale = TRUE;
+		}
+		glBindBuffer( GL_ARRAY_BUFFER, cache->buf );
+		if (cache->buf_stale) {
+			glBufferData( GL_ARRAY_BUFFER, 3 * cache->num_vertices * sizeof(float), cache->vertices, GL_STATIC_DRAW );
+			cache->buf_stale = FALSE;
+		}
+		pointer = NULL; /* (i.e. from the start of the buffer) */
+	}
+#endif
+	glVertexPointer( 3, GL_FLOAT, 0, pointer );
+}
+
+
+/* Draws the next count vertices of the bound cache, from *v onward */
+static void
+draw_part( int mode, int *v, int count )
+{
+	glDrawArrays( mode, *v, count );
+	*v += count;
+}
+
+
 static void
 draw_coord_axes( float percent, point *cam_pos )
 {
+	float rot_x, rot_y, rot_z;
+	int v = 0;
+
+	if (cache_stale( &axes_cache, percent ))
+		build_coord_axes( percent );
+	cache_bind( &axes_cache );
+
+	/* These will keep the arrowheads and labels facing the camera */
+	rot_x = DEG(atan2( cam_pos->z, cam_pos->y ));
+	rot_y = DEG(atan2( cam_pos->z, cam_pos->x ));
+	rot_z = DEG(atan2( cam_pos->y, cam_pos->x ));
+
+	/* Draw the terminating dots */
+	glPointSize( 8 );
+	glColor3f( 1.0, 0.0, 0.0 );
+	draw_part( GL_POINTS, &v, 2 );
+	glColor3f( 1.0, 1.0, 0.0 );
+	draw_part( GL_POINTS, &v, 2 );
+	glColor3f( 0.0, 0.0, 1.0 );
+	draw_part( GL_POINTS, &v, 2 );
+
+	/* Draw the axes */
+	glLineWidth( 5 );
+	glColor3f( 1.0, 0.0, 0.0 );
+	draw_part( GL_LINES, &v, 4 );
+	glColor3f( 1.0, 1.0, 0.0 );
+	draw_part( GL_LINES, &v, 4 );
+	glColor3f( 0.0, 0.0, 1.0 );
+	draw_part( GL_LINES, &v, 4 );
+
+	/* Draw the x-axis arrowhead and the X */
+	glPushMatrix( );
+	glRotatef( rot_x, 1.0, 0.0, 0.0 );
+	glColor3f( 1.0, 0.0, 0.0 );
+	draw_part( GL_TRIANGLE_FAN, &v, 4 );
+	draw_part( GL_LINES, &v, 4 );
+	glPopMatrix( );
+
+	/* Draw the y-axis arrowhead and the Y */
+	glPushMatrix( );
+	glRotatef( rot_y, 0.0, -1.0, 0.0 );
+	glColor3f( 1.0, 1.0, 0.0 );
+	draw_part( GL_TRIANGLE_FAN, &v, 4 );
+	/* (flipped if x-pos. of camera is negative) */
+	if (cam_pos->x < 0.0)
+		glScalef( 1.0, 1.0, -1.0 );
+	draw_part( GL_LINES, &v, 6 );
+	glPopMatrix( );
+
+	/* Draw the z-axis arrowhead and the Z */
+	glPushMatrix( );
+	glRotatef( rot_z, 0.0, 0.0, 1.0 );
+	glColor3f( 0.0, 0.0, 1.0 );
+	draw_part( GL_TRIANGLE_FAN, &v, 4 );
+	draw_part( GL_LINE_STRIP, &v, 4 );
+	glPopMatrix( );
+}
+
+
+/* Builds the coordinate axes, in the order draw_coord_axes( ) goes
+ * through them */
+static void
+build_coord_axes( float percent )
+{
+	aux_cache *c = &axes_cache;
 	float space, scale;
 	float x_dist;
 	float neg_x0, neg_y0, neg_z0;
 	float neg_x1, neg_y1, neg_z1;
 	float pos_x0, pos_y0, pos_z0;
 	float pos_x1, pos_y1, pos_z1;
-	float rot_x, rot_y, rot_z;
 	float arrow1, arrow2;
 	float label1, label2;
-	float label2_x;
 
 	/* These will be used to draw the axis arrowheads */
 	arrow1 = vehicle_extents.avg * percent / 8;
@@ -143,119 +298,65 @@ draw_coord_axes( float percent, point *cam_pos )
 	neg_z0 = vehicle_extents.zmin - space;
 	neg_z1 = MIN(neg_z0 * scale, - pos_z1) - arrow2 / 2.0;
 
-	/* These will keep the arrowheads and labels facing the camera */
-	rot_x = DEG(atan2( cam_pos->z, cam_pos->y ));
-	rot_y = DEG(atan2( cam_pos->z, cam_pos->x ));
-	rot_z = DEG(atan2( cam_pos->y, cam_pos->x ));
-
-	/* label2_x is used to flip the Y if x-pos. of camera is negative */
-	if (cam_pos->x < 0.0)
-		label2_x = - label2;
-	else
-		label2_x = label2;
-
-	/* Draw the terminating dots */
-	glPointSize( 8 );
-	glBegin( GL_POINTS );
-	glColor3f( 1.0, 0.0, 0.0 );
-	glVertex3f( neg_x0, 0, 0 );
-	glVertex3f( pos_x0, 0, 0 );
-	glColor3f( 1.0, 1.0, 0.0 );
-	glVertex3f( 0, neg_y0, 0 );
-	glVertex3f( 0, pos_y0, 0 );
-	glColor3f( 0.0, 0.0, 1.0 );
-	glVertex3f( 0, 0, neg_z0 );
-	glVertex3f( 0, 0, pos_z0 );
-	glEnd( );
-
-	/* Draw the axes */
-	glLineWidth( 5 );
-	glBegin( GL_LINES );
-	glColor3f( 1.0, 0.0, 0.0 );
-	glVertex3f( neg_x0, 0, 0 );
-	glVertex3f( neg_x1, 0, 0 );
-	glVertex3f( pos_x0, 0, 0 );
-	glVertex3f( pos_x1, 0, 0 );
-	glColor3f( 1.0, 1.0, 0.0 );
-	glVertex3f( 0, neg_y0, 0 );
-	glVertex3f( 0, neg_y1, 0 );
-	glVertex3f( 0, pos_y0, 0 );
-	glVertex3f( 0, pos_y1, 0 );
-	glColor3f( 0.0, 0.0, 1.0 );
-	glVertex3f( 0, 0, neg_z0 );
-	glVertex3f( 0, 0, neg_z1 );
-	glVertex3f( 0, 0, pos_z0 );
-	glVertex3f( 0, 0, pos_z1 );
-	glEnd( );
-
-	glPushMatrix( );
-	glRotatef( rot_x, 1.0, 0.0, 0.0 );
-
-	/* Draw the x-axis arrowhead */
-	glBegin( GL_TRIANGLE_FAN );
-	glColor3f( 1.0, 0.0, 0.0 );
-	glVertex3f( pos_x1, 0, 0 );
-	glVertex3f( pos_x1 - arrow1, 0, arrow1 / 2 );
-	glVertex3f( pos_x1 + arrow2, 0, 0 ); /* tip */
-	glVertex3f( pos_x1 - arrow1, 0, - arrow1 / 2 );
-	glEnd( );
-
-	/* Draw the X */
-	glBegin( GL_LINES );
-	glColor3f( 1.0, 0.0, 0.0 );
-	glVertex3f( neg_x1 - label2 - label1, 0, label2 ); /* top left */
-	glVertex3f( neg_x1 - label2 + label1, 0, - label2 ); /* bottom right */
-	glVertex3f( neg_x1 - label2 - label1, 0, - label2 ); /* bottom left */
-	glVertex3f( neg_x1 - label2 + label1, 0, label2 ); /* top right */
-	glEnd( );
-
-	glPopMatrix( );
-	glPushMatrix( );
-	glRotatef( rot_y, 0.0, -1.0, 0.0 );
-
-	/* Draw the y-axis arrowhead */
-	glBegin( GL_TRIANGLE_FAN );
-	glColor3f( 1.0, 1.0, 0.0 );
-	glVertex3f( 0, pos_y1, 0 );
-	glVertex3f( 0, pos_y1 - arrow1, - arrow1 / 2 );
-	glVertex3f( 0, pos_y1 + arrow2, 0 ); /* tip */
-	glVertex3f( 0, pos_y1 - arrow1, arrow1 / 2 );
-	glEnd( );
-
-	/* Draw the Y */
-	glBegin( GL_LINES );
-	glColor3f( 1.0, 1.0, 0.0 );
-	glVertex3f( 0, neg_y1 - label2 - label1, label2_x ); /* top left */
-	glVertex3f( 0, neg_y1 - label2, 0 ); /* middle */
-	glVertex3f( 0, neg_y1 - label2 + label1, label2_x ); /* top right */
-	glVertex3f( 0, neg_y1 - label2, 0 ); /* middle */
-	glVertex3f( 0, neg_y1 - label2, 0 ); /* middle */
-	glVertex3f( 0, neg_y1 - label2, - label2_x ); /* bottom */
-	glEnd( );
-
-	glPopMatrix( );
-	glPushMatrix( );
-	glRotatef( rot_z, 0.0, 0.0, 1.0 );
-
-	/* Draw the z-axis arrowhead */
-	glBegin( GL_TRIANGLE_FAN );
-	glColor3f( 0.0, 0.0, 1.0 );
-	glVertex3f( 0, 0, pos_z1 );
-	glVertex3f( 0, arrow1 / 2, pos_z1 - arrow1 );
-	glVertex3f( 0, 0, pos_z1 + arrow2 ); /* tip */
-	glVertex3f( 0, - arrow1 / 2, pos_z1 - arrow1 );
-	glEnd( );
-
-	/* Draw the Z */
-	glBegin( GL_LINE_STRIP );
-	glColor3f( 0.0, 0.0, 1.0 );
-	glVertex3f( 0, - label1, neg_z1 - label2 ); /* top left */
-	glVertex3f( 0, label1, neg_z1 - label2 );
-	glVertex3f( 0, - label1, neg_z1 - 3 * label2 );
-	glVertex3f( 0, label1, neg_z1 - 3 * label2 ); /* bottom right */
-	glEnd( );
-
-	glPopMatrix( );
+	/* The terminating dots */
+	cache_vertex( c, neg_x0, 0, 0 );
+	cache_vertex( c, pos_x0, 0, 0 );
+	cache_vertex( c, 0, neg_y0, 0 );
+	cache_vertex( c, 0, pos_y0, 0 );
+	cache_vertex( c, 0, 0, neg_z0 );
+	cache_vertex( c, 0, 0, pos_z0 );
+
+	/* The axes */
+	cache_vertex( c, neg_x0, 0, 0 );
+	cache_vertex( c, neg_x1, 0, 0 );
+	cache_vertex( c, pos_x0, 0, 0 );
+	cache_vertex( c, pos_x1, 0, 0 );
+	cache_vertex( c, 0, neg_y0, 0 );
+	cache_vertex( c, 0, neg_y1, 0 );
+	cache_vertex( c, 0, pos_y0, 0 );
+	cache_vertex( c, 0, pos_y1, 0 );
+	cache_vertex( c, 0, 0, neg_z0 );
+	cache_vertex( c, 0, 0, neg_z1 );
+	cache_vertex( c, 0, 0, pos_z0 );
+	cache_vertex( c, 0, 0, pos_z1 );
+
+	/* The x-axis arrowhead */
+	cache_vertex( c, pos_x1, 0, 0 );
+	cache_vertex( c, pos_x1 - arrow1, 0, arrow1 / 2 );
+	cache_vertex( c, pos_x1 + arrow2, 0, 0 ); /* tip */
+	cache_vertex( c, pos_x1 - arrow1, 0, - arrow1 / 2 );
+
+	/* The X */
+	cache_vertex( c, neg_x1 - label2 - label1, 0, label2 ); /* top left */
+	cache_vertex( c, neg_x1 - label2 + label1, 0, - label2 ); /* bottom right */
+	cache_vertex( c, neg_x1 - label2 - label1, 0, - label2 ); /* bottom left */
+	cache_vertex( c, neg_x1 - label2 + label1, 0, label2 ); /* top right */
+
+	/* The y-axis arrowhead */
+	cache_vertex( c, 0, pos_y1, 0 );
+	cache_vertex( c, 0, pos_y1 - arrow1, - arrow1 / 2 );
+	cache_vertex( c, 0, pos_y1 + arrow2, 0 ); /* tip */
+	cache_vertex( c, 0, pos_y1 - arrow1, arrow1 / 2 );
+
+	/* The Y (as seen from positive x) */
+	cache_vertex( c, 0, neg_y1 - label2 - label1, label2 ); /* top left */
+	cache_vertex( c, 0, neg_y1 - label2, 0 ); /* middle */
+	cache_vertex( c, 0, neg_y1 - label2 + label1, label2 ); /* top right */
+	cache_vertex( c, 0, neg_y1 - label2, 0 ); /* middle */
+	cache_vertex( c, 0, neg_y1 - label2, 0 ); /* middle */
+	cache_vertex( c, 0, neg_y1 - label2, - label2 ); /* bottom */
+
+	/* The z-axis arrowhead */
+	cache_vertex( c, 0, 0, pos_z1 );
+	cache_vertex( c, 0, arrow1 / 2, pos_z1 - arrow1 );
+	cache_vertex( c, 0, 0, pos_z1 + arrow2 ); /* tip */
+	cache_vertex( c, 0, - arrow1 / 2, pos_z1 - arrow1 );
+
+	/* The Z */
+	cache_vertex( c, 0, - label1, neg_z1 - label2 ); /* top left */
+	cache_vertex( c, 0, label1, neg_z1 - label2 );
+	cache_vertex( c, 0, - label1, neg_z1 - 3 * label2 );
+	cache_vertex( c, 0, label1, neg_z1 - 3 * label2 ); /* bottom right */
 }
 
 
@@ -264,11 +365,6 @@ draw_floating_grid( float percent )
 {
 	float angle;
 	float vis;
-	float unit_size;
-	float x_length, y_length;
-	float y_dist;
-	int i_min, j_min;
-	int i_max, j_max;
 
 	/* Deployment rotation */
 	angle = 180.0 * (percent - 1.0);
@@ -279,31 +375,24 @@ draw_floating_grid( float percent )
 	else
 		vis = sqrt( - percent );
 
-	/* Determine unit_size suited to vehicle dimensions */
-	unit_size = pow( 10, floor( log10( vehicle_extents.avg ) ) );
-
-	/* and grid extents */
-	x_length = vehicle_extents.xmax - vehicle_extents.xmin;
-	y_length = vehicle_extents.ymax - vehicle_extents.ymin;
-	y_dist = MAX(vehicle_extents.ymax, - vehicle_extents.ymin);
-	y_dist += y_length / 4;
-
-	i_max = (int)(ceil( 4 * x_length / unit_size )) / 2;
-	i_min = - i_max;
-	j_max = (int)(ceil( 4 * y_dist / unit_size ));
-	j_min = (int)(ceil( y_dist / unit_size ));
+	/* (the grid itself is the same however far deployed) */
+	if (cache_stale( &grid_cache, 1.0 ))
+		build_floating_grid( );
+	cache_bind( &grid_cache );
 
 	glPushMatrix( );
 	glRotatef( angle, 0.0, 1.0, 0.0 );
 	glEnable( GL_BLEND ); /* for fadein/fadeout */
 
-	draw_floating_grid_AUX( unit_size, i_min, i_max, j_min, j_max, vis, 1.0 );
+	draw_floating_grid_AUX( vis );
 
 	glPopMatrix( );
 	glPushMatrix( );
 	glRotatef( - angle, 0.0, 1.0, 0.0 );
+	/* (the other half is a mirror image) */
+	glScalef( 1.0, -1.0, 1.0 );
 
-	draw_floating_grid_AUX( unit_size, i_min, i_max, j_min, j_max, vis, -1.0 );
+	draw_floating_grid_AUX( vis );
 
 	glDisable( GL_BLEND );
 	glPopMatrix( );
@@ -311,46 +400,77 @@ draw_floating_grid( float percent )
 
 /* ThisIsAHelperFunction */
 static void
-draw_floating_grid_AUX( float unit_size, int i_min, int i_max, int j_min, int j_max, float vis, float side )
+draw_floating_grid_AUX( float vis )
+{
+	int num_line_vertices;
+
+	/* (the outer boundaries are the last four vertices) */
+	num_line_vertices = grid_cache.num_vertices - 4;
+
+	glLineWidth( 1 );
+	glColor4f( 0.5, 0.5, 0.5, vis );
+	glDrawArrays( GL_LINES, 0, num_line_vertices );
+	glLineWidth( 3 );
+
+	/* Outer boundaries */
+	glColor4f( 0.75, 0.75, 0.75, vis );
+	glDrawArrays( GL_LINE_STRIP, num_line_vertices, 4 );
+}
+
+
+/* Builds one half of the floating grid, the one on the positive y side */
+static void
+build_floating_grid( void )
 {
+	aux_cache *c = &grid_cache;
+	float unit_size;
+	float x_length, y_length;
+	float y_dist;
 	float x0, y0;
 	float x1, y1;
 	float x, y;
+	int i_min, j_min;
+	int i_max, j_max;
 	int i, j;
 
+	/* Determine unit_size suited to vehicle dimensions */
+	unit_size = pow( 10, floor( log10( vehicle_extents.avg ) ) );
+
+	/* and grid extents */
+	x_length = vehicle_extents.xmax - vehicle_extents.xmin;
+	y_length = vehicle_extents.ymax - vehicle_extents.ymin;
+	y_dist = MAX(vehicle_extents.ymax, - vehicle_extents.ymin);
+	y_dist += y_length / 4;
+
+	i_max = (int)(ceil( 4 * x_length / unit_size )) / 2;
+	i_min = - i_max;
+	j_max = (int)(ceil( 4 * y_dist / unit_size ));
+	j_min = (int)(ceil( y_dist / unit_size ));
+
 	x0 = unit_size * (float)i_min;
 	x1 = unit_size * (float)i_max;
 	y0 = unit_size * (float)j_min;
 	y1 = unit_size * (float)j_max;
 
-	glLineWidth( 1 );
-	glBegin( GL_LINES );
-	glColor4f( 0.5, 0.5, 0.5, vis );
-
 	/* x grid lines */
 	for (j = j_min; j < j_max; j++) {
 		y = unit_size * (float)j;
-		glVertex3f( x0, side * y, 0 );
-		glVertex3f( x1, side * y, 0 );
+		cache_vertex( c, x0, y, 0 );
+		cache_vertex( c, x1, y, 0 );
 	}
 
 	/* y grid lines */
 	for (i = i_min + 1; i < i_max; i++) {
 		x = unit_size * (float)i;
-		glVertex3f( x, side * y0, 0 );
-		glVertex3f( x, side * y1, 0 );
+		cache_vertex( c, x, y0, 0 );
+		cache_vertex( c, x, y1, 0 );
 	}
-	glEnd( );
-	glLineWidth( 3 );
 
 	/* Outer boundaries */
-	glBegin( GL_LINE_STRIP );
-	glColor4f( 0.75, 0.75, 0.75, vis );
-	glVertex3f( x0, side * y0, 0 );
-	glVertex3f( x0, side * y1, 0 );
-	glVertex3f( x1, side * y1, 0 );
-	glVertex3f( x1, side * y0, 0 );
-	glEnd( );
+	cache_vertex( c, x0, y0, 0 );
+	cache_vertex( c, x0, y1, 0 );
+	cache_vertex( c, x1, y1, 0 );
+	cache_vertex( c, x1, y0, 0 );
 
 	/* Floating grid determines world extents */
 	world_extents.xmin = x0;
@@ -360,58 +480,78 @@ draw_floating_grid_AUX( float unit_size, int i_min, int i_max, int j_min, int j_
 
 static void
 draw_bounding_box( float percent )
+{
+	float gamma;
+
+	if (percent < 0.01)
+		return;
+
+	if (cache_stale( &bbox_cache, percent ))
+		build_bounding_box( percent );
+	cache_bind( &bbox_cache );
+
+	/* The box is built around the vehicle at rest; its contraction and
+	 * position go by the velocity, so they are left to the matrix */
+	gamma = lorentz_factor( velocity );
+	glPushMatrix( );
+	glTranslatef( vehicle_real_x / percent, 0.0, 0.0 );
+	glScalef( 1.0 / (gamma * percent), 1.0 / percent, 1.0 / percent );
+
+	glLineWidth( 5 );
+	glColor3f( 1.0, 1.0, 1.0 );
+	glDrawArrays( GL_LINES, 0, bbox_cache.num_vertices );
+
+	glPopMatrix( );
+}
+
+
+/* Builds the bounding box (or rather, its corners) of the vehicle at rest */
+static void
+build_bounding_box( float percent )
 {
 	static int b[] = { 1, -1, -1, 2 }; /* Elements 0 and 3 are important */
+	aux_cache *c = &bbox_cache;
 	extents *exts;
 	float bar_percent;
-	float gamma;
 	float xbar, ybar, zbar; /* Length of x, y, z bars */
 	float bb_x[4], bb_y[4], bb_z[4]; /* x, y, z coords. of box/bars */
 	int i, j, k;
 
-	if (percent < 0.01)
-		return;
-
 	bar_percent = (0.25 / MAGIC_NUMBER) * percent;
-	gamma = lorentz_factor( velocity );
 	exts = &vehicle_extents; /* abbreviation */
 
 	xbar = (exts->xmax - exts->xmin) * bar_percent;
-	bb_x[0] = (exts->xmin / gamma + vehicle_real_x) / percent;
-	bb_x[1] = ((exts->xmin + xbar) / gamma + vehicle_real_x) / percent;
-	bb_x[2] = ((exts->xmax - xbar) / gamma + vehicle_real_x) / percent;
-	bb_x[3] = (exts->xmax / gamma + vehicle_real_x) / percent;
+	bb_x[0] = exts->xmin;
+	bb_x[1] = exts->xmin + xbar;
+	bb_x[2] = exts->xmax - xbar;
+	bb_x[3] = exts->xmax;
 
 	ybar = (exts->ymax - exts->ymin) * bar_percent;
-	bb_y[0] = exts->ymin / percent;
-	bb_y[1] = (exts->ymin + ybar) / percent;
-	bb_y[2] = (exts->ymax - ybar) / percent;
-	bb_y[3] = exts->ymax / percent;
+	bb_y[0] = exts->ymin;
+	bb_y[1] = exts->ymin + ybar;
+	bb_y[2] = exts->ymax - ybar;
+	bb_y[3] = exts->ymax;
 
 	zbar = (exts->zmax - exts->zmin) * bar_percent;
-	bb_z[0] = exts->zmin / percent;
-	bb_z[1] = (exts->zmin + zbar) / percent;
-	bb_z[2] = (exts->zmax - zbar) / percent;
-	bb_z[3] = exts->zmax / percent;
+	bb_z[0] = exts->zmin;
+	bb_z[1] = exts->zmin + zbar;
+	bb_z[2] = exts->zmax - zbar;
+	bb_z[3] = exts->zmax;
 
-	glLineWidth( 5 );
-	glBegin( GL_LINES );
-	glColor3f( 1.0, 1.0, 1.0 );
 	for (i = 0; i <= 3; i += 3) {
 		for (j = 0; j <= 3; j += 3) {
 			for (k = 0; k <= 3; k += 3) {
-				glVertex3f( bb_x[i], bb_y[j], bb_z[k] );
-				glVertex3f( bb_x[b[i]], bb_y[j], bb_z[k] );
+				cache_vertex( c, bb_x[i], bb_y[j], bb_z[k] );
+				cache_vertex( c, bb_x[b[i]], bb_y[j], bb_z[k] );
 
-				glVertex3f( bb_x[i], bb_y[j], bb_z[k] );
-				glVertex3f( bb_x[i], bb_y[b[j]], bb_z[k] );
+				cache_vertex( c, bb_x[i], bb_y[j], bb_z[k] );
+				cache_vertex( c, bb_x[i], bb_y[b[j]], bb_z[k] );
 
-				glVertex3f( bb_x[i], bb_y[j], bb_z[k] );
-				glVertex3f( bb_x[i], bb_y[j], bb_z[b[k]] );
+				cache_vertex( c, bb_x[i], bb_y[j], bb_z[k] );
+				cache_vertex( c, bb_x[i], bb_y[j], bb_z[b[k]] );
 			}
 		}
 	}
-	glEnd( );
 }
 
 /* end auxobjects.c */
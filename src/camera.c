@@ -49,6 +49,15 @@ new_camera( void )
 	usr_cams[new_cam_id]->window_w = NULL;
 	usr_cams[new_cam_id]->ogl_w = NULL;
 
+	/* Warped geometry buffers are allocated by warp( ) as needed */
+	usr_cams[new_cam_id]->view = NULL;
+	usr_cams[new_cam_id]->next_view = NULL;
+	usr_cams[new_cam_id]->next_ready = FALSE;
+	usr_cams[new_cam_id]->visible = NULL;
+	/* ...and uploaded to the GL by ogl_draw( ) */
+	usr_cams[new_cam_id]->vbuf = 0;
+	usr_cams[new_cam_id]->vbuf_serial = 0;
+
 	return usr_cams[new_cam_id];
 }
 
@@ -57,8 +66,10 @@ new_camera( void )
 void
 kill_camera( int cam_id )
 {
+	ogl_release_buffers( usr_cams[cam_id] );
 	gtk_widget_destroy( usr_cams[cam_id]->ogl_w );
 	gtk_widget_destroy( usr_cams[cam_id]->window_w );
+	warp( RESET, usr_cams[cam_id] );
 	xfree( usr_cams[cam_id] );
 	--num_cams;
 	if (cam_id != num_cams) /* Not last camera? */
@@ -222,6 +233,7 @@ int
 camera_move( GtkWidget *widget, GdkEventAny *event, void *nothing )
 {
 	static camera *cam;
+	static GtkWidget *press_w;
 	static float mouse_prev_x;
 	static float mouse_prev_y;
 	static int cam_id;
@@ -237,10 +249,15 @@ camera_move( GtkWidget *widget, GdkEventAny *event, void *nothing )
 
 	switch (event->type) {
 	case GDK_BUTTON_PRESS:
+		ev_button = (GdkEventButton *)event;
+		press_w = widget;
 		cam_id = assoc_cam_id( widget );
+		/* (in split view, the primary viewport has every camera in
+		 * it, and it's whichever was clicked on) */
+		if (split_view && (cam_id == 0))
+			cam_id = ogl_split_pane_at( ev_button->x, ev_button->y );
 		cam = usr_cams[cam_id];
 		cur_cam = cam_id;
-		ev_button = (GdkEventButton *)event;
 		/* Note click coordinates (for dragging) */
 		mouse_prev_x = ev_button->x;
 		mouse_prev_y = ev_button->y;
@@ -255,6 +272,8 @@ camera_move( GtkWidget *widget, GdkEventAny *event, void *nothing )
 			set_cursor_glyph( GDK_FLEUR );
 		if (ev_button->button == 3)
 			set_cursor_glyph( GDK_DOUBLE_ARROW );
+		/* Views get extrapolated while dragging */
+		warp( WARP_INTERACTIVE, MESG_(TRUE) );
 		/* Finally, clear out any stale text in velocity entry */
 		velocity_input( NULL, MESG_(RESET) );
 		return FALSE;
@@ -267,13 +286,19 @@ camera_move( GtkWidget *widget, GdkEventAny *event, void *nothing )
 	case GDK_BUTTON_RELEASE:
 		set_cursor_glyph( GDK_LEFT_PTR );
 		over_foreign = FALSE;
+		/* Have the extrapolated views warped exactly */
+		warp( WARP_INTERACTIVE, MESG_(FALSE) );
+		if (cam_id != 0)
+			queue_redraw( cam_id );
+		else
+			queue_redraw( -1 );
 		return FALSE;
 
 	case GDK_MOTION_NOTIFY:
 		ev_motion = (GdkEventMotion *)event;
 		mouse_x = ev_motion->x;
 		mouse_y = ev_motion->y;
-		if ((cam_id != assoc_cam_id( widget )) != over_foreign) {
+		if ((widget != press_w) != over_foreign) {
 			/* Fix for when pointer is dragged over another GL widget
 			 * (x/y coords. jump to something else completely) */
 			mouse_prev_x = mouse_x;
@@ -37,6 +37,8 @@ command( const char *input )
 	    "MEMSTATS",
 	    "MEMBLOCKS",
 	    "DGAMMA=",
+	    "THREADS=",
+	    "PIPELINE=",
 	    "STRAKER",
 	    "SKUNK"
 	};
@@ -102,14 +104,35 @@ command( const char *input )
 		if (f == 1.0)
 			dgamma_correct = FALSE;
 		else {
+			/* Warped views have the old gamma baked in (and
+			 * this also waits for any warp in the background) */
+			warp( RESET, NULL );
 			dgamma_correct = TRUE;
 			calc_dgamma_lut( f );
 		}
 		queue_redraw( -1 );
 		return 0;
 
-	case 7: /* STRAKER */
-	case 8: /* SKUNK */
+	case 7: /* THREADS= */
+		/* Set number of warp engine threads (0 == automatic) */
+		i = strtol( arg, NULL, 10 );
+		if ((i < 0) || (i > MAX_WARP_THREADS))
+			return -1;
+		warp_pool_init( i );
+		return 0;
+
+	case 8: /* PIPELINE= */
+		/* Set warp pipeline depth (1 == synchronous warping,
+		 * 2 == warp next frame while drawing this one) */
+		i = strtol( arg, NULL, 10 );
+		if ((i < 1) || (i > 2))
+			return -1;
+		warp( WARP_PIPELINE_DEPTH, &i );
+		queue_redraw( -1 );
+		return 0;
+
+	case 9: /* STRAKER */
+	case 10: /* SKUNK */
 		ss( ); /* // */
 		return 0;
 
@@ -0,0 +1,531 @@
+/* export.c */
+
+/* Animation export, as frames rendered off-screen */
+
+/*
+ *  ``The contents of this file are subject to the Mozilla Public License
+ *  Version 1.0 (the "License"); you may not use this file except in
+ *  compliance with the License. You may obtain a copy of the License at
+ *  http://www.mozilla.org/MPL/
+ *
+ *  Software distributed under the License is distributed on an "AS IS"
+ *  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+ *  License for the specific language governing rights and limitations
+ *  under the License.
+ *
+ *  The Original Code is the "Light Speed!" relativistic simulator.
+ *
+ *  The Initial Developer of the Original Code is Daniel Richard G.
+ *  Portions created by the Initial Developer are Copyright (C) 1999
+ *  Daniel Richard G. <skunk@mit.edu> All Rights Reserved.
+ *
+ *  Contributor(s): ______________________________________.''
+ */
+
+
+#include "lightspeed.h"
+
+#ifdef WITH_HEADLESS_RENDERER
+
+#ifdef WITH_THREADED_WARP
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+
+/* RGB to YCbCr (ITU-R BT.601, studio range) */
+#define RGB_Y(r,g,b)	((( 66 * (r) + 129 * (g) +  25 * (b) + 128) >> 8) + 16)
+#define RGB_U(r,g,b)	(((-38 * (r) -  74 * (g) + 112 * (b) + 128) >> 8) + 128)
+#define RGB_V(r,g,b)	(((112 * (r) -  94 * (g) -  18 * (b) + 128) >> 8) + 128)
+
+
+/* A frame read back from the GL, on its way to being encoded */
+typedef struct {
+	int num;		/* Frame number */
+	unsigned char *pixels;	/* RGBA, bottom row first (as the GL has it) */
+} export_frame;
+
+
+/* Output: numbered image files, or one YUV4MPEG2 stream */
+static const char *out_name;
+static int out_format;		/* IMAGE_FORMAT_???, or -1 for Y4M */
+static FILE *y4m_fp = NULL;
+static int frame_width, frame_height;
+static int scratch_size;
+
+/* Frame buffers, each either free or queued for encoding (oldest first) */
+static export_frame *frames = NULL;
+static export_frame **free_frames = NULL;
+static export_frame **queue = NULL;
+static int num_buffers;
+static int num_free;
+static int queue_head, queue_len;
+/* Next frame due in the Y4M stream */
+static int next_frame_out;
+static int export_failed;
+
+/* Encoder threads. With none, frames are encoded as they are queued */
+static int num_threads = 0;
+#ifdef WITH_THREADED_WARP
+static pthread_t *threads = NULL;
+static pthread_mutex_t export_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t free_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t order_cond = PTHREAD_COND_INITIALIZER;
+static int encoders_done = FALSE;
+#endif
+
+
+/* Converts a frame to planar YUV 4:2:0 (top row first), with each chroma
+ * sample the average of a 2x2 block of pixels */
+static void
+rgba_to_yuv420( const unsigned char *pixels, unsigned char *yuv )
+{
+	const unsigned char *src, *src2;
+	unsigned char *y_plane, *u_plane, *v_plane;
+	int cw, ch;
+	int r, g, b;
+	int x, y, x2;
+
+	cw = (frame_width + 1) / 2;
+	ch = (frame_height + 1) / 2;
+	y_plane = yuv;
+	u_plane = yuv + frame_width * frame_height;
+	v_plane = u_plane + cw * ch;
+
+	for (y = 0; y < frame_height; y++) {
+		src = pixels + 4 * (frame_height - 1 - y) * frame_width;
+		for (x = 0; x < frame_width; x++) {
+			r = src[4 * x];
+			g = src[4 * x + 1];
+			b = src[4 * x + 2];
+			*(y_plane++) = RGB_Y(r, g, b);
+		}
+	}
+
+	for (y = 0; y < ch; y++) {
+		/* (odd sizes repeat the last row/column) */
+		src = pixels + 4 * (frame_height - 1 - 2 * y) * frame_width;
+		src2 = src - 4 * MIN(1, frame_height - 1 - 2 * y) * frame_width;
+		for (x = 0; x < cw; x++) {
+			x2 = MIN(2 * x + 1, frame_width - 1);
+			r = src[8 * x] + src[4 * x2] + src2[8 * x] + src2[4 * x2];
+			g = src[8 * x + 1] + src[4 * x2 + 1] + src2[8 * x + 1] + src2[4 * x2 + 1];
+			b = src[8 * x + 2] + src[4 * x2 + 2] + src2[8 * x + 2] + src2[4 * x2 + 2];
+			r = (r + 2) >> 2;
+			g = (g + 2) >> 2;
+			b = (b + 2) >> 2;
+			*(u_plane++) = RGB_U(r, g, b);
+			*(v_plane++) = RGB_V(r, g, b);
+		}
+	}
+}
+
+
+/* Appends a frame to the Y4M stream, once all the ones before it are in.
+ * scratch holds the converted frame. Returns FALSE on a write error */
+static int
+write_frame_y4m( export_frame *frame, unsigned char *scratch )
+{
+	size_t size;
+	int ok;
+
+	rgba_to_yuv420( frame->pixels, scratch );
+	size = frame_width * frame_height + 2 * ((frame_width + 1) / 2) * ((frame_height + 1) / 2);
+
+#ifdef WITH_THREADED_WARP
+	pthread_mutex_lock( &export_lock );
+	while (next_frame_out != frame->num)
+		pthread_cond_wait( &order_cond, &export_lock );
+	ok = !export_failed;
+	pthread_mutex_unlock( &export_lock );
+#else
+	ok = !export_failed;
+#endif
+	if (ok) {
+		fputs( "FRAME\n", y4m_fp );
+		ok = (fwrite( scratch, 1, size, y4m_fp ) == size);
+	}
+#ifdef WITH_THREADED_WARP
+	pthread_mutex_lock( &export_lock );
+	++next_frame_out;
+	pthread_cond_broadcast( &order_cond );
+	pthread_mutex_unlock( &export_lock );
+#else
+	++next_frame_out;
+#endif
+
+	return ok;
+}
+
+
+/* Writes a frame to an image file of its own: out_name with the frame
+ * number ahead of the extension (e.g. anim0000.png, anim0001.png...)
+ * scratch holds one RGB row. Returns FALSE on a write error */
+static int
+write_frame_image( export_frame *frame, unsigned char *scratch )
+{
+	image_file *img;
+	const unsigned char *src;
+	const char *ext;
+	char *filename;
+	int x, y;
+	int ok = TRUE;
+
+	ext = strrchr( out_name, '.' );
+	filename = xmalloc( strlen( out_name ) + 16 );
+	sprintf( filename, "%.*s%04d%s", (int)(ext - out_name), out_name, frame->num, ext );
+	img = image_open( filename, frame_width, frame_height );
+	if (img == NULL) {
+		xfree( filename );
+		return FALSE;
+	}
+
+	for (y = frame_height - 1; ok && (y >= 0); y--) {
+		src = frame->pixels + 4 * y * frame_width;
+		for (x = 0; x < frame_width; x++) {
+			scratch[3 * x] = src[4 * x];
+			scratch[3 * x + 1] = src[4 * x + 1];
+			scratch[3 * x + 2] = src[4 * x + 2];
+		}
+		ok = image_write_rows( img, scratch, 0, 1 );
+	}
+	if (!image_close( img ))
+		ok = FALSE;
+	if (!ok)
+		fprintf( stderr, "ERROR: Cannot write image file: %s\n", filename );
+	xfree( filename );
+
+	return ok;
+}
+
+
+static int
+encode_frame( export_frame *frame, unsigned char *scratch )
+{
+	if (out_format < 0)
+		return write_frame_y4m( frame, scratch );
+	else
+		return write_frame_image( frame, scratch );
+}
+
+
+#ifdef WITH_THREADED_WARP
+/* Encoder thread: takes frames off the queue until there are no more */
+static void *
+encoder( void *unused )
+{
+	export_frame *frame;
+	unsigned char *scratch;
+	int ok;
+
+	scratch = xmalloc( scratch_size );
+
+	pthread_mutex_lock( &export_lock );
+	while (TRUE) {
+		while ((queue_len == 0) && !encoders_done)
+			pthread_cond_wait( &queue_cond, &export_lock );
+		if (queue_len == 0)
+			break;
+		frame = queue[queue_head];
+		queue_head = (queue_head + 1) % num_buffers;
+		--queue_len;
+		pthread_mutex_unlock( &export_lock );
+
+		ok = encode_frame( frame, scratch );
+
+		pthread_mutex_lock( &export_lock );
+		if (!ok)
+			export_failed = TRUE;
+		free_frames[num_free++] = frame;
+		pthread_cond_signal( &free_cond );
+	}
+	pthread_mutex_unlock( &export_lock );
+
+	xfree( scratch );
+
+	return NULL;
+}
+#endif /* WITH_THREADED_WARP */
+
+
+/* Gets the frame buffers and encoder threads ready */
+static void
+start_encoders( void )
+{
+	int n, i;
+
+	n = 0;
+#ifdef WITH_THREADED_WARP
+	n = DEF_EXPORT_THREADS;
+	if (n <= 0)
+		n = sysconf( _SC_NPROCESSORS_ONLN );
+	n = CLAMP(n, 1, MAX_WARP_THREADS);
+#endif
+
+	/* Two frames per thread can wait their turn (bounding memory use
+	 * if encoding falls behind) */
+	num_buffers = 2 * MAX(1, n);
+	frames = xmalloc( num_buffers * sizeof(export_frame) );
+	free_frames = xmalloc( num_buffers * sizeof(export_frame *) );
+	queue = xmalloc( num_buffers * sizeof(export_frame *) );
+	for (i = 0; i < num_buffers; i++) {
+		frames[i].pixels = xmalloc( 4 * frame_width * frame_height );
+		free_frames[i] = &frames[i];
+	}
+	num_free = num_buffers;
+	queue_head = 0;
+	queue_len = 0;
+	next_frame_out = 0;
+	export_failed = FALSE;
+
+	if (out_format < 0)
+		scratch_size = frame_width * frame_height + 2 * ((frame_width + 1) / 2) * ((frame_height + 1) / 2);
+	else
+		scratch_size = 3 * frame_width;
+
+	num_threads = 0;
+#ifdef WITH_THREADED_WARP
+	encoders_done = FALSE;
+	threads = xmalloc( n * sizeof(pthread_t) );
+	for (i = 0; i < n; i++) {
+		if (pthread_create( &threads[i], NULL, encoder, NULL ) != 0)
+			break;
+		++num_threads;
+	}
+#endif
+}
+
+
+/* Waits for the encoders to get through the queue, then shuts them down */
+static void
+stop_encoders( void )
+{
+	int i;
+
+#ifdef WITH_THREADED_WARP
+	pthread_mutex_lock( &export_lock );
+	encoders_done = TRUE;
+	pthread_cond_broadcast( &queue_cond );
+	pthread_mutex_unlock( &export_lock );
+	for (i = 0; i < num_threads; i++)
+		pthread_join( threads[i], NULL );
+	xfree( threads );
+	threads = NULL;
+#endif
+	num_threads = 0;
+
+	for (i = 0; i < num_buffers; i++)
+		xfree( frames[i].pixels );
+	xfree( frames );
+	xfree( free_frames );
+	xfree( queue );
+	frames = NULL;
+}
+
+
+/* Returns a frame buffer to read the next frame into, waiting for one to
+ * come free if need be. NULL if encoding has failed */
+static export_frame *
+get_free_frame( void )
+{
+	export_frame *frame = NULL;
+
+#ifdef WITH_THREADED_WARP
+	pthread_mutex_lock( &export_lock );
+	while ((num_free == 0) && !export_failed)
+		pthread_cond_wait( &free_cond, &export_lock );
+	if (!export_failed)
+		frame = free_frames[--num_free];
+	pthread_mutex_unlock( &export_lock );
+#else
+	if (!export_failed)
+		frame = free_frames[--num_free];
+#endif
+
+	return frame;
+}
+
+
+/* Hands a frame over to be encoded */
+static void
+queue_frame( export_frame *frame )
+{
+	unsigned char *scratch;
+
+	if (num_threads == 0) {
+		/* No encoder threads, so do it here and now */
+		scratch = xmalloc( scratch_size );
+		if (!encode_frame( frame, scratch ))
+			export_failed = TRUE;
+		xfree( scratch );
+		free_frames[num_free++] = frame;
+		return;
+	}
+
+#ifdef WITH_THREADED_WARP
+	pthread_mutex_lock( &export_lock );
+	queue[(queue_head + queue_len) % num_buffers] = frame;
+	++queue_len;
+	pthread_cond_signal( &queue_cond );
+	pthread_mutex_unlock( &export_lock );
+#endif
+}
+
+
+/* Exports one loop of the vehicle's animation, anim[ ] = { x0, x1,
+ * loop_time } (as in the Objects/Animation dialog), at fps frames per
+ * second of loop time. The scene is set up as for render_headless( ), and
+ * frames are stepped through at exactly 1/fps apart, regardless of how
+ * long they take to draw. They go to numbered image files, or to a
+ * YUV4MPEG2 stream if out_file ends in .y4m. Each frame is read back while
+ * the next ones are drawn, and encoded by a pool of threads. Returns the
+ * program's exit status */
+int
+export_animation( const char *obj_file, const char *out_file, int width, int height, const float *view, const float *anim, float fps )
+{
+	camera *cam;
+	export_frame *frame;
+	const char *version;
+	void *pixels;
+	unsigned int pbos[EXPORT_FRAMES_IN_FLIGHT];
+	double t0, t;
+	int use_pbos = FALSE;
+	int read_failed = FALSE;
+	int major = 1, minor = 1;
+	int num_frames, in_flight;
+	int frame_size;
+	int len, i, j;
+
+	/* What to write */
+	out_name = out_file;
+	len = strlen( out_file );
+	if ((len > 4) && !strcasecmp( &out_file[len - 4], ".y4m" ))
+		out_format = -1;
+	else {
+		out_format = image_format( out_file );
+		if (out_format < 0) {
+			fprintf( stderr, "ERROR: Cannot write images of this type: %s\n", out_file );
+			return -1;
+		}
+	}
+	/* (same limits as the Objects/Animation dialog) */
+	if (((anim[1] - anim[0]) < 0.5) || (anim[2] <= 0.0) || (fps <= 0.0)) {
+		fprintf( stderr, "ERROR: Invalid animation parameters\n" );
+		return -1;
+	}
+	num_frames = MAX(1, (int)(anim[2] * fps + 0.5));
+	frame_width = width;
+	frame_height = height;
+	frame_size = 4 * width * height;
+
+	cam = render_begin( obj_file, width, height, view, FALSE );
+	if (cam == NULL)
+		return -1;
+
+	if (out_format < 0) {
+		y4m_fp = fopen( out_file, "wb" );
+		if (y4m_fp == NULL) {
+			fprintf( stderr, "ERROR: Cannot write video file: %s\n", out_file );
+			render_end( );
+			return -1;
+		}
+		if (fps == (int)fps)
+			fprintf( y4m_fp, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, (int)fps );
+		else
+			fprintf( y4m_fp, "YUV4MPEG2 W%d H%d F%d:1000 Ip A1:1 C420jpeg\n", width, height, (int)(1000.0 * fps + 0.5) );
+	}
+	start_encoders( );
+
+	/* Pixel pack buffers (OpenGL 2.1) let glReadPixels( ) return without
+	 * waiting for the frame to be finished */
+#ifdef GL_VERSION_2_1
+	version = (const char *)glGetString( GL_VERSION );
+	if (version != NULL)
+		sscanf( version, "%d.%d", &major, &minor );
+	use_pbos = (major > 2) || ((major == 2) && (minor >= 1));
+	if (use_pbos) {
+		glGenBuffers( EXPORT_FRAMES_IN_FLIGHT, pbos );
+		for (i = 0; i < EXPORT_FRAMES_IN_FLIGHT; i++) {
+			glBindBuffer( GL_PIXEL_PACK_BUFFER, pbos[i] );
+			glBufferData( GL_PIXEL_PACK_BUFFER, frame_size, NULL, GL_STREAM_READ );
+		}
+	}
+#endif /* GL_VERSION_2_1 */
+	in_flight = use_pbos ? EXPORT_FRAMES_IN_FLIGHT : 1;
+	glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+
+	t0 = read_system_clock( );
+	for (i = 0; i < (num_frames + in_flight - 1); i++) {
+		if (i < num_frames) {
+			/* Step the animation to frame i, and draw it */
+			warp_time( anim[0], anim[1], (double)i / (double)num_frames, WARP_SET_ANIM );
+			memcpy( &out_cam, cam, sizeof(camera) );
+			ogl_draw( -1 );
+#ifdef GL_VERSION_2_1
+			if (use_pbos) {
+				glBindBuffer( GL_PIXEL_PACK_BUFFER, pbos[i % in_flight] );
+				glReadPixels( 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, NULL );
+			}
+#endif
+		}
+
+		/* Collect the oldest frame in flight */
+		j = i - (in_flight - 1);
+		if (j < 0)
+			continue;
+		frame = get_free_frame( );
+		if (frame == NULL)
+			break;
+		frame->num = j;
+#ifdef GL_VERSION_2_1
+		if (use_pbos) {
+			glBindBuffer( GL_PIXEL_PACK_BUFFER, pbos[j % in_flight] );
+			pixels = glMapBuffer( GL_PIXEL_PACK_BUFFER, GL_READ_ONLY );
+			if (pixels == NULL) {
+				read_failed = TRUE;
+				break;
+			}
+			memcpy( frame->pixels, pixels, frame_size );
+			glUnmapBuffer( GL_PIXEL_PACK_BUFFER );
+		}
+		else
+#endif /* GL_VERSION_2_1 */
+			glReadPixels( 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, frame->pixels );
+		queue_frame( frame );
+	}
+
+	stop_encoders( );
+	t = read_system_clock( ) - t0;
+	if (read_failed) {
+		fprintf( stderr, "ERROR: Cannot read back frame %d\n", j );
+		export_failed = TRUE;
+	}
+
+#ifdef GL_VERSION_2_1
+	if (use_pbos) {
+		glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+		glDeleteBuffers( EXPORT_FRAMES_IN_FLIGHT, pbos );
+	}
+#endif
+	render_end( );
+
+	if (y4m_fp != NULL) {
+		if (fclose( y4m_fp ) != 0)
+			export_failed = TRUE;
+		y4m_fp = NULL;
+		if (export_failed)
+			fprintf( stderr, "ERROR: Cannot write video file: %s\n", out_file );
+	}
+	if (export_failed)
+		return -1;
+
+	printf( "Exported %d frames in %.2f sec (%.2f fps)\n", num_frames, t, (double)num_frames / t );
+	fflush( stdout );
+
+	return 0;
+}
+
+#endif /* WITH_HEADLESS_RENDERER */
+
+/* end export.c */
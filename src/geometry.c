@@ -37,6 +37,12 @@ alloc_ogl_object( int num_vertices, int num_indices )
 	new_obj->num_vertices = num_vertices;
 	new_obj->vertices0 = xmalloc( num_vertices * sizeof(point) );
 	new_obj->normals0 = xmalloc( num_vertices * sizeof(point) );
+	new_obj->soa0 = NULL; /* built on demand by update_ogl_object_soa( ) */
+	new_obj->soa_stride = 0;
+	new_obj->vertices_lc = NULL; /* these are the warp engine's */
+	new_obj->normals_lc = NULL;
+	new_obj->soa_lc = NULL;
+	new_obj->lc_gamma = 0.0;
 	new_obj->iarrays = xmalloc( num_vertices * sizeof(ogl_point) );
 	/* Initialize "a" fields in iarrays, since we don't really use them */
 	for (i = 0; i < num_vertices; i++)
@@ -45,6 +51,12 @@ alloc_ogl_object( int num_vertices, int num_indices )
 	new_obj->indices = xmalloc( num_indices * sizeof(unsigned int) );
 	new_obj->pre_dlist = 0; /* null display list */
 	new_obj->post_dlist = 0; /* ditto */
+	new_obj->index_buf = 0; /* created by ogl_draw( ) */
+	new_obj->orig_num_vertices = 0; /* see strip_ogl_object( ) */
+	new_obj->orig_num_indices = 0;
+	new_obj->orig_cache_misses = 0; /* see reorder_ogl_object( ) */
+	new_obj->meshlets = NULL; /* built on demand */
+	new_obj->num_meshlets = 0;
 
 	return new_obj;
 }
@@ -59,6 +71,10 @@ calc_ogl_object_memusage( int num_vertices, int num_indices )
 
 	/* The vertices0 and normals0 arrays */
 	num_bytes = 2 * num_vertices * sizeof(point);
+	/* The SoA geometry streams (six of them, padded) */
+	num_bytes += 6 * (num_vertices + WARP_SIMD_WIDTH) * sizeof(float);
+	/* The contracted copy of either of the above */
+	num_bytes += 6 * (num_vertices + WARP_SIMD_WIDTH) * sizeof(float);
 	/* The C4F+N3F+V3F superarray */
 	num_bytes += num_vertices * sizeof(ogl_point);
 	/* The indices array */
@@ -76,22 +92,447 @@ free_ogl_object( ogl_object *obj )
 {
 	xfree( obj->vertices0 );
 	xfree( obj->normals0 );
+	if (obj->soa0 != NULL)
+		xfree( obj->soa0 );
+	if (obj->vertices_lc != NULL) {
+		xfree( obj->vertices_lc );
+		xfree( obj->normals_lc );
+	}
+	if (obj->soa_lc != NULL)
+		xfree( obj->soa_lc );
+	if (obj->meshlets != NULL)
+		xfree( obj->meshlets );
 	xfree( obj->iarrays );
 	xfree( obj->indices );
 	if (obj->pre_dlist != 0)
 		glDeleteLists( obj->pre_dlist, 1 );
 	if (obj->post_dlist != 0)
 		glDeleteLists( obj->post_dlist, 1 );
+#ifdef WITH_BUFFER_OBJECTS
+	if (obj->index_buf != 0)
+		glDeleteBuffers( 1, &obj->index_buf );
+#endif
 	xfree( obj );
 }
 
 
+/* (Re)builds the structure-of-arrays copy of an object's unwarped geometry.
+ * The six streams (x, y, z, nx, ny, nz) each hold soa_stride floats, which is
+ * num_vertices rounded up to a multiple of WARP_SIMD_WIDTH, and start on
+ * 32-byte boundaries. Padding repeats the last vertex, so that the SIMD warp
+ * kernel can process whole blocks without special-casing the tail
+ * NOTE: Must be called again whenever vertices0/normals0 are modified */
+void
+update_ogl_object_soa( ogl_object *obj )
+{
+	float *x, *y, *z;
+	float *nx, *ny, *nz;
+	int stride;
+	int v, v_src;
+
+	stride = obj->num_vertices + WARP_SIMD_WIDTH - 1;
+	stride -= stride % WARP_SIMD_WIDTH;
+	stride = MAX(WARP_SIMD_WIDTH, stride);
+	if ((obj->soa0 == NULL) || (obj->soa_stride != stride)) {
+		if (obj->soa0 != NULL)
+			xfree( obj->soa0 );
+		obj->soa0 = xmalloc_aligned( 6 * stride * sizeof(float), 32 );
+		obj->soa_stride = stride;
+		/* (the contracted copy goes by the same stride) */
+		if (obj->soa_lc != NULL) {
+			xfree( obj->soa_lc );
+			obj->soa_lc = NULL;
+		}
+	}
+	/* Contracted geometry is out of date now */
+	obj->lc_gamma = 0.0;
+
+	x = obj->soa0;
+	y = &x[stride];
+	z = &y[stride];
+	nx = &z[stride];
+	ny = &nx[stride];
+	nz = &ny[stride];
+	for (v = 0; v < stride; v++) {
+		v_src = MIN(v, obj->num_vertices - 1);
+		x[v] = obj->vertices0[v_src].x;
+		y[v] = obj->vertices0[v_src].y;
+		z[v] = obj->vertices0[v_src].z;
+		nx[v] = obj->normals0[v_src].x;
+		ny[v] = obj->normals0[v_src].y;
+		nz[v] = obj->normals0[v_src].z;
+	}
+}
+
+
+/* (Re)builds an object's meshlets, i.e. splits its indices into runs of
+ * MESHLET_TRIANGLES triangles, each with the range of vertices it uses and
+ * their bounding box. Triangle strips are split at even positions (to keep
+ * their facing), with each run taking in the first two indices of the next.
+ * Other primitive types get a single meshlet
+ * NOTE: Must be called again whenever vertices0 or indices are modified */
+void
+update_ogl_object_meshlets( ogl_object *obj )
+{
+	ogl_meshlet *ml;
+	point *p;
+	int step, overlap = 0;
+	int m, i;
+
+	switch (obj->type) {
+	case GL_TRIANGLES:
+		step = 3 * MESHLET_TRIANGLES;
+		break;
+
+	case GL_TRIANGLE_STRIP:
+		step = MESHLET_TRIANGLES + (MESHLET_TRIANGLES % 2);
+		overlap = 2;
+		break;
+
+	default:
+		step = obj->num_indices;
+		break;
+	}
+	step = MAX(1, step);
+	obj->num_meshlets = MAX(1, (obj->num_indices - overlap + step - 1) / step);
+	if (obj->meshlets != NULL)
+		xfree( obj->meshlets );
+	obj->meshlets = xmalloc( obj->num_meshlets * sizeof(ogl_meshlet) );
+
+	for (m = 0; m < obj->num_meshlets; m++) {
+		ml = &obj->meshlets[m];
+		ml->i0 = m * step;
+		ml->num_indices = MIN(step + overlap, obj->num_indices - ml->i0);
+		ml->v0 = obj->num_vertices;
+		ml->v1 = 0;
+		ml->min.x = 1E30;
+		ml->min.y = 1E30;
+		ml->min.z = 1E30;
+		ml->max.x = -1E30;
+		ml->max.y = -1E30;
+		ml->max.z = -1E30;
+		for (i = ml->i0; i < (ml->i0 + ml->num_indices); i++) {
+			ml->v0 = MIN(ml->v0, (int)obj->indices[i]);
+			ml->v1 = MAX(ml->v1, (int)obj->indices[i] + 1);
+			p = &obj->vertices0[obj->indices[i]];
+			ml->min.x = MIN(ml->min.x, p->x);
+			ml->min.y = MIN(ml->min.y, p->y);
+			ml->min.z = MIN(ml->min.z, p->z);
+			ml->max.x = MAX(ml->max.x, p->x);
+			ml->max.y = MAX(ml->max.y, p->y);
+			ml->max.z = MAX(ml->max.z, p->z);
+		}
+	}
+}
+
+
+/* Score of a vertex in reorder_ogl_object( ), given its position in the
+ * simulated vertex cache (-1 == not in it) and the number of triangles
+ * yet to be drawn that use it (after T. Forsyth, "Linear-Speed Vertex
+ * Cache Optimisation", 2006). Vertices of the last triangle score a bit
+ * less than the next few, so as not to go back and forth along a strip,
+ * and vertices with few triangles left get a boost to finish them off */
+static float
+vertex_cache_score( int cache_pos, int num_tris )
+{
+	float score = 0.0;
+	float k;
+
+	if (num_tris == 0)
+		return -1.0;
+
+	if (cache_pos >= 3) {
+		k = 1.0 - (float)(cache_pos - 3) / (float)(VERTEX_CACHE_SIZE - 3);
+		score = k * sqrt( k ); /* k^1.5 */
+	}
+	else if (cache_pos >= 0)
+		score = 0.75;
+	score += 2.0 / sqrt( (float)num_tris );
+
+	return score;
+}
+
+
+/* Reorders the triangles of a GL_TRIANGLES object for the post-transform
+ * vertex cache (see VERTEX_CACHE_SIZE), greedily taking the next triangle
+ * with the best-scoring vertices. The vertices are then renumbered in order
+ * of first use, so that the GL (and whatever walks the indices) fetches
+ * them from memory more or less in sequence
+ * NOTE: Must be called before update_ogl_object_soa( ) */
+void
+reorder_ogl_object( ogl_object *obj )
+{
+	unsigned int *indices;
+	point *vertices, *normals;
+	float *vert_scores, *tri_scores;
+	float score, best_score;
+	int *vert_tris, *vert_tris_begin, *vert_num_tris;
+	int *cache_pos, *tri_done, *remap;
+	int cache[VERTEX_CACHE_SIZE + 3];
+	int new_cache[VERTEX_CACHE_SIZE + 3];
+	int cache_len = 0, new_len;
+	int num_tris;
+	int best_tri, next_tri = 0;
+	int n, t, i, j, k, v;
+
+	if (obj->type != GL_TRIANGLES)
+		return;
+
+	obj->orig_cache_misses = calc_cache_misses( obj );
+
+	num_tris = obj->num_indices / 3;
+	vert_num_tris = xmalloc( obj->num_vertices * sizeof(int) );
+	vert_tris_begin = xmalloc( (obj->num_vertices + 1) * sizeof(int) );
+	vert_tris = xmalloc( obj->num_indices * sizeof(int) );
+	vert_scores = xmalloc( obj->num_vertices * sizeof(float) );
+	cache_pos = xmalloc( obj->num_vertices * sizeof(int) );
+	tri_scores = xmalloc( num_tris * sizeof(float) );
+	tri_done = xmalloc( num_tris * sizeof(int) );
+	indices = xmalloc( obj->num_indices * sizeof(unsigned int) );
+
+	/* Triangles using each vertex (vertex v has vert_num_tris[v] of
+	 * them left, from vert_tris[vert_tris_begin[v]] on) */
+	for (v = 0; v < obj->num_vertices; v++)
+		vert_num_tris[v] = 0;
+	for (i = 0; i < obj->num_indices; i++)
+		++vert_num_tris[obj->indices[i]];
+	vert_tris_begin[0] = 0;
+	for (v = 0; v < obj->num_vertices; v++) {
+		vert_tris_begin[v + 1] = vert_tris_begin[v] + vert_num_tris[v];
+		vert_num_tris[v] = 0;
+	}
+	for (i = 0; i < obj->num_indices; i++) {
+		v = obj->indices[i];
+		vert_tris[vert_tris_begin[v] + vert_num_tris[v]++] = i / 3;
+	}
+
+	for (v = 0; v < obj->num_vertices; v++) {
+		cache_pos[v] = -1;
+		vert_scores[v] = vertex_cache_score( -1, vert_num_tris[v] );
+	}
+	best_tri = 0;
+	for (t = 0; t < num_tris; t++) {
+		tri_done[t] = FALSE;
+		tri_scores[t] = 0.0;
+		for (k = 0; k < 3; k++)
+			tri_scores[t] += vert_scores[obj->indices[3 * t + k]];
+		if (tri_scores[t] > tri_scores[best_tri])
+			best_tri = t;
+	}
+
+	for (n = 0; n < num_tris; n++) {
+		if (best_tri < 0) {
+			/* Nothing left around the cache, so start afresh */
+			while (tri_done[next_tri])
+				++next_tri;
+			best_tri = next_tri;
+		}
+
+		/* Draw the triangle, and put its vertices at the front
+		 * of the cache (the ones pushed off the end still need
+		 * rescoring, hence the extra 3) */
+		new_len = 0;
+		for (k = 0; k < 3; k++) {
+			v = obj->indices[3 * best_tri + k];
+			indices[3 * n + k] = v;
+			/* (take the triangle off the vertex's list) */
+			i = vert_tris_begin[v];
+			j = i + --vert_num_tris[v];
+			while (vert_tris[i] != best_tri)
+				++i;
+			vert_tris[i] = vert_tris[j];
+			vert_tris[j] = best_tri;
+			if (cache_pos[v] != -2) {
+				cache_pos[v] = -2;
+				new_cache[new_len++] = v;
+			}
+		}
+		tri_done[best_tri] = TRUE;
+		for (i = 0; i < cache_len; i++) {
+			if (cache_pos[cache[i]] != -2)
+				new_cache[new_len++] = cache[i];
+		}
+
+		/* Rescore the vertices in (or just out of) the cache, and the
+		 * triangles left that use them, picking the best of those */
+		best_tri = -1;
+		best_score = -1.0;
+		for (i = 0; i < new_len; i++) {
+			v = new_cache[i];
+			cache_pos[v] = (i < VERTEX_CACHE_SIZE) ? i : -1;
+			score = vertex_cache_score( cache_pos[v], vert_num_tris[v] );
+			for (j = 0; j < vert_num_tris[v]; j++)
+				tri_scores[vert_tris[vert_tris_begin[v] + j]] += score - vert_scores[v];
+			vert_scores[v] = score;
+		}
+		for (i = 0; i < new_len; i++) {
+			v = new_cache[i];
+			for (j = 0; j < vert_num_tris[v]; j++) {
+				t = vert_tris[vert_tris_begin[v] + j];
+				if (tri_scores[t] > best_score) {
+					best_tri = t;
+					best_score = tri_scores[t];
+				}
+			}
+		}
+		cache_len = MIN(new_len, VERTEX_CACHE_SIZE);
+		memcpy( cache, new_cache, cache_len * sizeof(int) );
+	}
+
+	/* Renumber the vertices in order of first use (any unused ones
+	 * go last) */
+	remap = cache_pos;
+	for (v = 0; v < obj->num_vertices; v++)
+		remap[v] = -1;
+	k = 0;
+	for (i = 0; i < obj->num_indices; i++) {
+		v = indices[i];
+		if (remap[v] < 0)
+			remap[v] = k++;
+		indices[i] = remap[v];
+	}
+	for (v = 0; v < obj->num_vertices; v++) {
+		if (remap[v] < 0)
+			remap[v] = k++;
+	}
+	vertices = xmalloc( obj->num_vertices * sizeof(point) );
+	normals = xmalloc( obj->num_vertices * sizeof(point) );
+	for (v = 0; v < obj->num_vertices; v++) {
+		vertices[remap[v]] = obj->vertices0[v];
+		normals[remap[v]] = obj->normals0[v];
+	}
+
+	xfree( obj->vertices0 );
+	xfree( obj->normals0 );
+	xfree( obj->indices );
+	obj->vertices0 = vertices;
+	obj->normals0 = normals;
+	obj->indices = indices;
+
+	xfree( vert_num_tris );
+	xfree( vert_tris_begin );
+	xfree( vert_tris );
+	xfree( vert_scores );
+	xfree( cache_pos );
+	xfree( tri_scores );
+	xfree( tri_done );
+}
+
+
+/* Number of vertex cache misses incurred in drawing a GL_TRIANGLES object
+ * (with a FIFO cache of VERTEX_CACHE_SIZE entries, as most hardware has) */
+int
+calc_cache_misses( ogl_object *obj )
+{
+	int cache[VERTEX_CACHE_SIZE];
+	int num_misses = 0;
+	int head = 0;
+	int i, j, v;
+
+	for (j = 0; j < VERTEX_CACHE_SIZE; j++)
+		cache[j] = -1;
+	for (i = 0; i < obj->num_indices; i++) {
+		v = obj->indices[i];
+		for (j = 0; j < VERTEX_CACHE_SIZE; j++) {
+			if (cache[j] == v)
+				break;
+		}
+		if (j < VERTEX_CACHE_SIZE)
+			continue;
+		cache[head] = v;
+		head = (head + 1) % VERTEX_CACHE_SIZE;
+		++num_misses;
+	}
+
+	return num_misses;
+}
+
+
+/* Converts a quad strip object, whose strips are tied together by repeated
+ * vertices (an index pair i,i), into a single triangle strip. The strips are
+ * cut at the tie points and joined by degenerate triangles instead, which
+ * takes two indices per join rather than four, and draws the same faces
+ * minus those to the tie points (which are hidden inside the geometry).
+ * Vertices used only as tie points are dropped, sparing the warp engine */
+void
+strip_ogl_object( ogl_object *obj )
+{
+	unsigned int *indices;
+	int *remap;
+	int num_indices = 0;
+	int strip_begin = -1;
+	int i, j, v;
+
+	if (obj->type != GL_QUAD_STRIP)
+		return;
+
+	/* Quad strip indices form a triangle strip as they are (with the
+	 * same facing), so only the tie points need taking out */
+	indices = xmalloc( obj->num_indices * sizeof(unsigned int) );
+	for (i = 0; i <= obj->num_indices; i += 2) {
+		if ((i < obj->num_indices - 1) && (obj->indices[i] != obj->indices[i + 1])) {
+			if (strip_begin < 0)
+				strip_begin = i;
+			continue;
+		}
+		/* End of a strip (needs two pairs to make anything) */
+		if ((strip_begin >= 0) && ((i - strip_begin) >= 4)) {
+			if (num_indices > 0) {
+				/* Degenerate join (keeps the strip at an even
+				 * position, hence its facing) */
+				indices[num_indices] = indices[num_indices - 1];
+				indices[num_indices + 1] = obj->indices[strip_begin];
+				num_indices += 2;
+			}
+			for (j = strip_begin; j < i; j++)
+				indices[num_indices++] = obj->indices[j];
+		}
+		strip_begin = -1;
+	}
+
+	/* Drop unreferenced vertices */
+	remap = xmalloc( obj->num_vertices * sizeof(int) );
+	for (v = 0; v < obj->num_vertices; v++)
+		remap[v] = -1;
+	for (i = 0; i < num_indices; i++)
+		remap[indices[i]] = 0;
+	j = 0;
+	for (v = 0; v < obj->num_vertices; v++) {
+		if (remap[v] < 0)
+			continue;
+		remap[v] = j;
+		obj->vertices0[j] = obj->vertices0[v];
+		obj->normals0[j] = obj->normals0[v];
+		++j;
+	}
+	for (i = 0; i < num_indices; i++)
+		indices[i] = remap[indices[i]];
+	xfree( remap );
+
+	obj->orig_num_vertices = obj->num_vertices;
+	obj->orig_num_indices = obj->num_indices;
+	obj->type = GL_TRIANGLE_STRIP;
+	obj->num_vertices = j;
+	obj->vertices0 = xrealloc( obj->vertices0, j * sizeof(point) );
+	obj->normals0 = xrealloc( obj->normals0, j * sizeof(point) );
+	obj->iarrays = xrealloc( obj->iarrays, j * sizeof(ogl_point) );
+	xfree( obj->indices );
+	obj->indices = xrealloc( indices, num_indices * sizeof(unsigned int) );
+	obj->num_indices = num_indices;
+	if (obj->soa0 != NULL)
+		update_ogl_object_soa( obj );
+}
+
+
 /* Gets rid of all current objects */
 void
 clear_all_objects( void )
 {
 	int i;
 
+	/* Cameras' warped copies go first */
+	warp( RESET, NULL );
+
 	for (i = 0; i < num_vehicle_objs; i++)
 		free_ogl_object( vehicle_objs[i] );
 	xfree( vehicle_objs );
@@ -138,7 +579,12 @@ rotate_all_objects( int direction )
 			obj->normals0[v].y = y;
 			obj->normals0[v].z = z;
 		}
+		if (obj->soa0 != NULL)
+			update_ogl_object_soa( obj );
+		if (obj->meshlets != NULL)
+			update_ogl_object_meshlets( obj );
 	}
+	warp( RESET, NULL );
 
 	/* Reset vehicle_extents */
 	vehicle_extents.xmin = xmin;
@@ -277,6 +723,8 @@ show_geometry_stats( void )
 	float ex,ey,ez;
 	int vnum, inum;
 	int vnum_total = 0, inum_total = 0;
+	int vnum_saved = 0, inum_saved = 0;
+	int num_tris = 0, num_misses = 0, num_misses0 = 0;
 	int i;
 
 	printf( "=========== Light Speed! geometry stats ===========\n" );
@@ -292,11 +740,26 @@ show_geometry_stats( void )
 		g = obj->color0.g;
 		b = obj->color0.b;
 		printf( "%6d%12d%11d    (%.2f, %.2f, %.2f)\n", i, vnum, inum, r, g, b );
+		if (obj->orig_num_vertices > 0) {
+			vnum_saved += obj->orig_num_vertices - vnum;
+			inum_saved += obj->orig_num_indices - inum;
+		}
+		if (obj->orig_cache_misses > 0) {
+			num_tris += inum / 3;
+			num_misses += calc_cache_misses( obj );
+			num_misses0 += obj->orig_cache_misses;
+		}
 	}
 	printf( "------    --------    -------    ------------------\n" );
 	printf( "Object    Vertices    Indices    RGB base color\n" );
 	printf( "------    --------    -------\n" );
 	printf( " Total%12d%11d\n", vnum_total, inum_total );
+	if ((vnum_saved > 0) || (inum_saved > 0))
+		printf( " Saved%12d%11d    (triangle strips)\n", vnum_saved, inum_saved );
+	if (num_tris > 0) {
+		printf( " Vertex cache misses: %.3f per triangle (%.3f before reordering)\n",
+		        (float)num_misses / (float)num_tris, (float)num_misses0 / (float)num_tris );
+	}
 	ex = vehicle_extents.xmax - vehicle_extents.xmin;
 	ey = vehicle_extents.ymax - vehicle_extents.ymin;
 	ez = vehicle_extents.zmax - vehicle_extents.zmin;
@@ -419,7 +882,8 @@ write_srs_mesh( FILE *srs, point *cam_pos, int visible_faces_only )
 	point *face_verts[4];
 	point *face_norms[4];
 	point *vert_a, *vert_b;
-	point tri_verts[3];
+	point *warped_verts = NULL;
+	point *tri_verts[3];
 	point *norm, *cent;
 	float dx,dy,dz;
 	float fdir;
@@ -456,6 +920,14 @@ write_srs_mesh( FILE *srs, point *cam_pos, int visible_faces_only )
 		num_faces = obj->num_indices / face_size;
 		face_flags = xmalloc( num_faces * sizeof(int) );
 
+		/* Faces are checked against the camera in their warped
+		 * state, so warp all of the object's vertices in one go */
+		if (visible_faces_only) {
+			warped_verts = xmalloc( obj->num_vertices * sizeof(point) );
+			memcpy( warped_verts, obj->vertices0, obj->num_vertices * sizeof(point) );
+			warp_points( warped_verts, NULL, obj->num_vertices, cam_pos );
+		}
+
 		/* First, check for good faces in this object
 		 * (good = no coincident vertices, no zero normals) */
 		at_least_one_good_face = FALSE;
@@ -494,15 +966,14 @@ write_srs_mesh( FILE *srs, point *cam_pos, int visible_faces_only )
 			if (visible_faces_only && !bad_face) {
 				for (i = 0; i < 3; i++) {
 					ind = obj->indices[base + i];
-					memcpy( &tri_verts[i], &obj->vertices0[ind], sizeof(point) );
-					warp_point( &tri_verts[i], NULL, cam_pos );
+					tri_verts[i] = &warped_verts[ind];
 				}
 				/* Calculate (warped) flat triangle normal
 				 * (for quads: 4th vertex is coplanar anyway) */
-				norm = calc_tri_normal( &tri_verts[0], &tri_verts[1], &tri_verts[2] );
+				norm = calc_tri_normal( tri_verts[0], tri_verts[1], tri_verts[2] );
 				/* Calculate (warped) centroid and then the
 				 * triangle-to-camera (reverse view) vector */
-				cent = calc_tri_centroid( &tri_verts[0], &tri_verts[1], &tri_verts[2] );
+				cent = calc_tri_centroid( tri_verts[0], tri_verts[1], tri_verts[2] );
 				dx = cam_pos->x - cent->x;
 				dy = cam_pos->y - cent->y;
 				dz = cam_pos->z - cent->z;
@@ -520,6 +991,11 @@ write_srs_mesh( FILE *srs, point *cam_pos, int visible_faces_only )
 			}
 		}
 
+		if (warped_verts != NULL) {
+			xfree( warped_verts );
+			warped_verts = NULL;
+		}
+
 		if (!at_least_one_good_face) {
 			xfree( face_flags );
 			continue;
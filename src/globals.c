@@ -120,13 +120,25 @@ int cur_cam;
 /* Output camera (for snapshots and SRS scenes) */
 camera out_cam;
 
+/* Split view flag: are all cameras drawn side by side in the primary
+ * viewport (see ogl_draw_split( )), rather than each in its own window? */
+int split_view = FALSE;
+
 /* Advanced interface flag (controls presence of extra features) */
 int advanced_interface = DEF_ADVANCED_INTERFACE;
 
+/* Flag: running without a display (see render.c), so there are no
+ * GTK+ widgets or fonts to be had */
+int headless = FALSE;
+
 /* Gamma correction flag & lookup table
  * NOTE: This is display gamma, not Lorentz factor gamma! */
 int dgamma_correct;
 float dgamma_lut[LUT_RES + 1];
+float dgamma_exp = 1.0; /* x^dgamma_exp == dgamma_lut[x] */
+/* Flag: is display gamma applied by the GL's vehicle shader, rather than
+ * by warp( )? (see ogl_initialize( )) */
+int shader_dgamma = FALSE;
 
 /* Mouse sensitivity setting */
 float mouse_sens = DEF_MOUSE_SENS;
@@ -87,6 +87,12 @@ message_window( const char *title, const char *message_text )
 	GtkWidget *frame_w;
 	GtkWidget *button_w;
 
+	if (headless) {
+		/* Nowhere else for it to go */
+		fprintf( stderr, "%s: %s\n", title, message_text );
+		return NULL;
+	}
+
 	message_window_w = make_dialog_window( title, NULL );
 	gtk_window_set_position( GTK_WINDOW(message_window_w), GTK_WIN_POS_MOUSE );
 	gtk_signal_connect( GTK_OBJECT(message_window_w), "delete_event",
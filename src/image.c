@@ -0,0 +1,222 @@
+/* image.c */
+
+/* Image file output */
+
+/*
+ *  ``The contents of this file are subject to the Mozilla Public License
+ *  Version 1.0 (the "License"); you may not use this file except in
+ *  compliance with the License. You may obtain a copy of the License at
+ *  http://www.mozilla.org/MPL/
+ *
+ *  Software distributed under the License is distributed on an "AS IS"
+ *  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+ *  License for the specific language governing rights and limitations
+ *  under the License.
+ *
+ *  The Original Code is the "Light Speed!" relativistic simulator.
+ *
+ *  The Initial Developer of the Original Code is Daniel Richard G.
+ *  Portions created by the Initial Developer are Copyright (C) 1999
+ *  Daniel Richard G. <skunk@mit.edu> All Rights Reserved.
+ *
+ *  Contributor(s): ______________________________________.''
+ */
+
+
+#include "lightspeed.h"
+
+#ifdef HAVE_LIBPNG
+#include <png.h>
+#endif
+#ifdef HAVE_LIBTIFF
+#include <tiffio.h>
+#endif
+
+
+/* Figures out the format of an image file from its name's extension
+ * (one of image_format_exts[ ]). Returns an IMAGE_FORMAT_??? value, or -1
+ * if it is not one that can be written */
+int
+image_format( const char *filename )
+{
+	int len, ext_len;
+	int i;
+
+	len = strlen( filename );
+	for (i = 0; i < NUM_IMAGE_FORMATS; i++) {
+		ext_len = strlen( image_format_exts[i] );
+		if (len <= ext_len)
+			continue;
+		if (strcasecmp( &filename[len - ext_len], image_format_exts[i] ))
+			continue;
+		switch (i) {
+#ifdef HAVE_LIBPNG
+		case IMAGE_FORMAT_PNG:
+			return i;
+#endif
+#ifdef HAVE_LIBTIFF
+		case IMAGE_FORMAT_TIFF:
+			return i;
+#endif
+		default:
+			return -1;
+		}
+	}
+
+	return -1;
+}
+
+
+/* Opens an image file for writing, as a width x height RGB image (8 bits
+ * per channel) whose rows are then handed to image_write_rows( ) top to
+ * bottom, so that the whole image needn't be held in memory at any time.
+ * Returns NULL (after printing why) if the file cannot be written */
+image_file *
+image_open( const char *filename, int width, int height )
+{
+	image_file *img;
+#ifdef HAVE_LIBPNG
+	png_structp png_ptr;
+	png_infop info_ptr;
+#endif
+
+	img = xmalloc( sizeof(image_file) );
+	img->format = image_format( filename );
+	img->width = width;
+	img->height = height;
+	img->row = 0;
+	img->fp = NULL;
+	img->writer = NULL;
+	img->info = NULL;
+
+	switch (img->format) {
+#ifdef HAVE_LIBPNG
+	case IMAGE_FORMAT_PNG:
+		img->fp = fopen( filename, "wb" );
+		if (img->fp == NULL)
+			break;
+		png_ptr = png_create_write_struct( PNG_LIBPNG_VER_STRING, NULL, NULL, NULL );
+		if (png_ptr == NULL)
+			break;
+		img->writer = png_ptr;
+		info_ptr = png_create_info_struct( png_ptr );
+		if (info_ptr == NULL)
+			break;
+		img->info = info_ptr;
+		if (setjmp( png_jmpbuf(png_ptr) ))
+			break;
+		png_init_io( png_ptr, img->fp );
+		png_set_IHDR( png_ptr, info_ptr, width, height, 8, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT );
+		png_write_info( png_ptr, info_ptr );
+		return img;
+#endif /* HAVE_LIBPNG */
+
+#ifdef HAVE_LIBTIFF
+	case IMAGE_FORMAT_TIFF:
+		img->writer = TIFFOpen( filename, "w" );
+		if (img->writer == NULL)
+			break;
+		TIFFSetField( img->writer, TIFFTAG_IMAGEWIDTH, (uint32_t)width );
+		TIFFSetField( img->writer, TIFFTAG_IMAGELENGTH, (uint32_t)height );
+		TIFFSetField( img->writer, TIFFTAG_BITSPERSAMPLE, 8 );
+		TIFFSetField( img->writer, TIFFTAG_SAMPLESPERPIXEL, 3 );
+		TIFFSetField( img->writer, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB );
+		TIFFSetField( img->writer, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG );
+		TIFFSetField( img->writer, TIFFTAG_COMPRESSION, COMPRESSION_LZW );
+		TIFFSetField( img->writer, TIFFTAG_ROWSPERSTRIP, TIFFDefaultStripSize( img->writer, 0 ) );
+		return img;
+#endif /* HAVE_LIBTIFF */
+
+	default:
+		fprintf( stderr, "ERROR: Cannot write images of this type: %s\n", filename );
+		xfree( img );
+		return NULL;
+	}
+
+	/* Something went wrong along the way */
+	fprintf( stderr, "ERROR: Cannot write image file: %s\n", filename );
+	image_close( img );
+	return NULL;
+}
+
+
+/* Writes the next num_rows rows of an image, given as packed RGB triplets
+ * at stride bytes from one row to the next (negative strides are fine,
+ * e.g. for the bottom-up rows that glReadPixels( ) gives). Returns FALSE
+ * on a write error */
+int
+image_write_rows( image_file *img, const unsigned char *rows, int stride, int num_rows )
+{
+#if defined(HAVE_LIBPNG) || defined(HAVE_LIBTIFF)
+	int i;
+#endif
+
+	num_rows = MIN(num_rows, img->height - img->row);
+	switch (img->format) {
+#ifdef HAVE_LIBPNG
+	case IMAGE_FORMAT_PNG:
+		if (setjmp( png_jmpbuf((png_structp)img->writer) ))
+			return FALSE;
+		for (i = 0; i < num_rows; i++)
+			png_write_row( (png_structp)img->writer, (png_const_bytep)(rows + i * stride) );
+		break;
+#endif
+
+#ifdef HAVE_LIBTIFF
+	case IMAGE_FORMAT_TIFF:
+		for (i = 0; i < num_rows; i++) {
+			if (TIFFWriteScanline( img->writer, (void *)(rows + i * stride), img->row + i, 0 ) < 0)
+				return FALSE;
+		}
+		break;
+#endif
+
+	default:
+		return FALSE;
+	}
+	img->row += num_rows;
+
+	return TRUE;
+}
+
+
+/* Finishes off an image file. Returns FALSE if it could not be written
+ * in full */
+int
+image_close( image_file *img )
+{
+	/* (volatile, as it is set across a setjmp( )) */
+	volatile int ok;
+
+	ok = (img->row == img->height);
+	switch (img->format) {
+#ifdef HAVE_LIBPNG
+	case IMAGE_FORMAT_PNG:
+		if (img->writer == NULL)
+			break;
+		if (setjmp( png_jmpbuf((png_structp)img->writer) ))
+			ok = FALSE;
+		else if (ok)
+			png_write_end( (png_structp)img->writer, NULL );
+		png_destroy_write_struct( (png_structpp)&img->writer, (png_infopp)&img->info );
+		break;
+#endif
+
+#ifdef HAVE_LIBTIFF
+	case IMAGE_FORMAT_TIFF:
+		if (img->writer != NULL)
+			TIFFClose( img->writer );
+		break;
+#endif
+
+	default:
+		break;
+	}
+	if ((img->fp != NULL) && (fclose( img->fp ) != 0))
+		ok = FALSE;
+	xfree( img );
+
+	return ok;
+}
+
+/* end image.c */
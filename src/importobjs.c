@@ -312,9 +312,12 @@ import_3ds( r3ds_scene *scene )
 	vehicle_extents.zmax = zmax;
 	vehicle_extents.avg = ((xmax - xmin) + (ymax - ymin) + (zmax - zmin)) / 3;
 
-	/* Finally, tessellate the objects so that they deform nicely */
-	for (o = 0; o < num_vehicle_objs; o++)
+	/* Finally, tessellate the objects so that they deform nicely,
+	 * and put the result in an order that draws well */
+	for (o = 0; o < num_vehicle_objs; o++) {
 		tessellate_object( vehicle_objs[o], 8 );
+		reorder_ogl_object( vehicle_objs[o] );
+	}
 
 	return 0;
 }
@@ -229,6 +229,10 @@ make_lattice( int size_x, int size_y, int size_z, int smoothness )
 	fflush( stdout );
 #endif
 
+	/* Drop the tie points between balls/sticks */
+	strip_ogl_object( lattice_balls );
+	strip_ogl_object( lattice_sticks );
+
 	vehicle_objs = xmalloc( 2 * sizeof(ogl_object *) );
 	vehicle_objs[0] = lattice_balls;
 	vehicle_objs[1] = lattice_sticks;
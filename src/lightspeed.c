@@ -50,7 +50,7 @@ cmdline_help( const char *execname )
 
 	printf( STR_CLI_usage_ARG, execname );
 	printf( "\n" );
-	for (i = 0; i < 4; i++) {
+	for (i = 0; i < 10; i++) {
 		opt = STRS_CLI_options[i].opt;
 		lopt = STRS_CLI_options[i].lopt;
 		desc = STRS_CLI_options[i].desc;
@@ -77,23 +77,36 @@ main( int argc, char **argv )
 setup_gettext();
 
 #ifdef HAVE_GETOPT_LONG
-	struct option long_options[4];
+	struct option long_options[10];
 #endif
 	int opt, i;
 	char *init_obj_file = NULL;
+	char *render_file = NULL;
+	char *end;
+#ifdef WITH_HEADLESS_RENDERER
+	float render_view[3];
+	float render_anim[3];
+	float render_fps = DEF_EXPORT_FPS;
+	int render_width = DEF_RENDER_WIDTH;
+	int render_height = DEF_RENDER_HEIGHT;
+	int render_view_set = FALSE;
+	int render_anim_set = FALSE;
+#endif
+	double v;
 
 #ifdef HAVE_GETOPT_LONG
 	/* Initialize long-options array */
-	for (i = 0; i < 3; i++) {
+	for (i = 0; i < 9; i++) {
 		long_options[i].name = STRS_CLI_options[i].lopt;
-		long_options[i].has_arg = no_argument;
+		/* (-r, -v, -c, -g, -x and -f take an argument) */
+		long_options[i].has_arg = (i < 3) ? no_argument : required_argument;
 		long_options[i].flag = NULL;
 		long_options[i].val = STRS_CLI_options[i].opt;
 	}
-	long_options[3].name = 0;
-	long_options[3].has_arg = 0;
-	long_options[3].flag = 0;
-	long_options[3].val = 0;
+	long_options[9].name = 0;
+	long_options[9].has_arg = 0;
+	long_options[9].flag = 0;
+	long_options[9].val = 0;
 #endif /* HAVE_GETOPT_LONG */
 
 	/* Parse command-line options */
@@ -121,12 +134,73 @@ setup_gettext();
 			advanced_interface = TRUE;
 			break;
 		}
+		if (opt == STRS_CLI_options[3].opt) {
+			/* -r --render */
+			render_file = optarg;
+			continue;
+		}
+		if (opt == STRS_CLI_options[4].opt) {
+			/* -v --velocity */
+			v = strtod( optarg, &end );
+			if ((*end == 'c') || (*end == 'C'))
+				v *= C;
+			velocity = CLAMP(v, MIN_VELOCITY, MAX_VELOCITY);
+			continue;
+		}
+#ifdef WITH_HEADLESS_RENDERER
+		/* (these only go with --render, which needs the headless
+		 * renderer) */
+		if (opt == STRS_CLI_options[5].opt) {
+			/* -c --camera */
+			if (sscanf( optarg, "%f,%f,%f", &render_view[0], &render_view[1], &render_view[2] ) != 3) {
+				cmdline_help( argv[0] );
+				return -1;
+			}
+			render_view_set = TRUE;
+			continue;
+		}
+		if (opt == STRS_CLI_options[6].opt) {
+			/* -g --size */
+			if ((sscanf( optarg, "%dx%d", &render_width, &render_height ) != 2) || (render_width < 1) || (render_height < 1)) {
+				cmdline_help( argv[0] );
+				return -1;
+			}
+			continue;
+		}
+		if (opt == STRS_CLI_options[7].opt) {
+			/* -x --animate */
+			if (sscanf( optarg, "%f,%f,%f", &render_anim[0], &render_anim[1], &render_anim[2] ) != 3) {
+				cmdline_help( argv[0] );
+				return -1;
+			}
+			render_anim_set = TRUE;
+			continue;
+		}
+		if (opt == STRS_CLI_options[8].opt) {
+			/* -f --fps */
+			render_fps = strtod( optarg, NULL );
+			continue;
+		}
+#endif /* WITH_HEADLESS_RENDERER */
 	}
 	if (optind < argc) {
 		/* object */
 		init_obj_file = argv[optind];
 	}
 
+	if (render_file != NULL) {
+		/* Batch image generation, no display needed */
+#ifdef WITH_HEADLESS_RENDERER
+		if (render_anim_set)
+			return export_animation( init_obj_file, render_file, render_width, render_height, render_view_set ? render_view : NULL, render_anim, render_fps );
+		return render_headless( init_obj_file, render_file, render_width, render_height, render_view_set ? render_view : NULL );
+#else
+		fprintf( stderr, "Light Speed! was built without headless rendering support.\n" );
+		fflush( stderr );
+		return -1;
+#endif /* not WITH_HEADLESS_RENDERER */
+	}
+
 	/* Initialize profiling */
 	profile( INITIALIZE );
 
@@ -31,6 +31,7 @@
 /* The usual headers */
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #ifdef HAVE_GETOPT_H
 #include <getopt.h>
 #endif /* HAVE_GETOPT_H */
@@ -38,7 +39,8 @@
 #include <string.h>
 #include <sys/time.h>
 
-/* OpenGL */
+/* OpenGL (with prototypes for the post-1.1 entry points) */
+#define GL_GLEXT_PROTOTYPES
 #include <GL/gl.h>
 #include <GL/glx.h>
 
@@ -51,6 +53,25 @@
 /* Compile-time settings */
 #include "settings.h"
 
+/* Buffer objects need OpenGL 1.5 headers */
+#if defined(WITH_BUFFER_OBJECTS) && !defined(GL_VERSION_1_5)
+#undef WITH_BUFFER_OBJECTS
+#endif
+
+/* The shader renderer needs buffer objects, and OpenGL 3.3 headers */
+#if defined(WITH_SHADER_RENDERER) && (!defined(WITH_BUFFER_OBJECTS) || !defined(GL_VERSION_3_3))
+#undef WITH_SHADER_RENDERER
+#endif
+
+/* Headless rendering needs a way to get a GL context without a display,
+ * and something to write the image with */
+#if defined(WITH_HEADLESS_RENDERER) && !defined(HAVE_EGL) && !defined(HAVE_OSMESA)
+#undef WITH_HEADLESS_RENDERER
+#endif
+#if defined(WITH_HEADLESS_RENDERER) && !defined(HAVE_LIBPNG) && !defined(HAVE_LIBTIFF)
+#undef WITH_HEADLESS_RENDERER
+#endif
+
 /* Optional memory allocation tracking */
 #ifdef WITH_TRACKMEM
 #include "trackmem.h"
@@ -89,6 +110,59 @@
 /* a value counterpart to NULL */
 #define NIL			0
 
+/* The SIMD warp kernel needs GCC-style target attributes and an x86 CPU */
+#if defined(WITH_SIMD_WARP) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define WARP_SIMD_X86
+#endif
+/* Vertices processed per iteration of the SIMD warp kernel; the SoA
+ * geometry streams are padded to a multiple of this */
+#define WARP_SIMD_WIDTH		8
+/* Forces a function to be inlined, so that it gets specialized for constant
+ * arguments (used to generate the warp kernel variants) */
+#ifdef __GNUC__
+#define ALWAYS_INLINE		inline __attribute__((always_inline))
+#else
+#define ALWAYS_INLINE		inline
+#endif
+
+/* Relativistic effects, as bits of warp_params.effects. Each combination
+ * has its own warp kernel variant, with the code for the rest left out */
+#define WARP_FX_CONTRACTION	1
+#define WARP_FX_DEFORMATION	2
+#define WARP_FX_DOPPLER		4
+#define WARP_FX_HEADLIGHT	8
+#define WARP_FX_COLOR		(WARP_FX_DOPPLER | WARP_FX_HEADLIGHT)
+#define WARP_FX_ALL		15
+
+/* Polynomial approximations for the warp kernels (see WARP_POLY_APPROX),
+ * fitted minimax over [0, 1]:
+ *	2/pi * atan( x ) = x * P(x^2)	max. error 7.3E-6
+ *	log2( 1 + t ) = t * P(t)	max. error 1.4E-5
+ *	2^f = 1 + f * P(f)		max. error 4.2E-6 */
+#define WARP_ATAN_P0		0.636534675f
+#define WARP_ATAN_P1		-0.210278557f
+#define WARP_ATAN_P2		0.114692969f
+#define WARP_ATAN_P3		-0.0542122167f
+#define WARP_ATAN_P4		0.0132704119f
+#define WARP_LOG2_P0		1.44196562f
+#define WARP_LOG2_P1		-0.709662829f
+#define WARP_LOG2_P2		0.417595804f
+#define WARP_LOG2_P3		-0.196269659f
+#define WARP_LOG2_P4		0.0463853687f
+#define WARP_EXP2_P0		0.69301853f
+#define WARP_EXP2_P1		0.241445504f
+#define WARP_EXP2_P2		0.0519505494f
+#define WARP_EXP2_P3		0.0135812478f
+
+/* Most error deform_dist( ) may have, in radians of view angle, i.e. a
+ * few ulps of float (2^-23). deform_precision_check( ) fails past this */
+#define WARP_DEFORM_MAX_ERROR	(4.0 / 8388608.0)
+
+/* Image file formats (indices into image_format_exts[ ]) */
+#define IMAGE_FORMAT_PNG	0
+#define IMAGE_FORMAT_TIFF	1
+#define NUM_IMAGE_FORMATS	2
+
 /* Macro for message passing via pointer */
 #define MESG_(m)		((int *)&mesg_vals[m])
 
@@ -117,14 +191,22 @@ enum {
 
 	/* relativistic distortion control by warp( ) */
 	WARP_DISTORT,
+	WARP_DISTORT_CAMERA,
+	WARP_DISTORT_CAMERAS,
+	WARP_DISTORT_AHEAD,
+	WARP_CULL,
 	WARP_LORENTZ_CONTRACTION,
 	WARP_OPTICAL_DEFORMATION,
 	WARP_DOPPLER_SHIFT,
 	WARP_HEADLIGHT_EFFECT,
+	WARP_BENCHMARK,
+	WARP_PIPELINE_DEPTH,
+	WARP_INTERACTIVE,
 	/* time and animation control by warp_time( ) */
 	WARP_UPDATE_TIME_T,
 	WARP_BEGIN_ANIM,
 	WARP_STOP_ANIM,
+	WARP_SET_ANIM,
 
 	/* performance profiling control by profile( ) */
 	PROFILE_START_ITERATION,
@@ -189,6 +271,18 @@ enum {
 
 /**** Data structures ****************************************************/
 
+/* Image file being written, a few rows at a time (see image.c) */
+typedef struct image_file_struct image_file;
+struct image_file_struct {
+	int format;		/* IMAGE_FORMAT_??? */
+	int width, height;
+	int row;		/* Rows written so far */
+	FILE *fp;
+	void *writer;		/* Library's handle on the file... */
+	void *info;		/* ...and whatever else it needs */
+};
+
+
 /* Command-line option description */
 struct option_desc {
 	char opt;	/* Short option */
@@ -266,6 +360,47 @@ struct ogl_point_struct {
 };
 
 
+/* Vertex as the shader renderer takes it (see WITH_SHADER_RENDERER):
+ * location, then normal in 2:10:10:10 signed fixed point, then color
+ * in 8-bit RGBA. Half the size of an ogl_point */
+typedef struct ogl_packed_point_struct ogl_packed_point;
+struct ogl_packed_point_struct {
+	float x;
+	float y;
+	float z;
+	unsigned int normal;
+	unsigned char r;
+	unsigned char g;
+	unsigned char b;
+	unsigned char a;
+};
+
+
+/* Geometry of an auxiliary object (see auxobjects.c), kept from frame to
+ * frame and rebuilt only when what it was built for changes */
+typedef struct aux_cache_struct aux_cache;
+struct aux_cache_struct {
+	float *vertices;	/* XYZ triples */
+	int num_vertices;
+	int max_vertices;	/* (room in vertices) */
+	extents exts;		/* Vehicle extents it was built for */
+	float percent;		/* ...and deployment percentage */
+	int built;		/* Flag: has it been built at all? */
+	unsigned int buf;	/* GL buffer object with the vertices, */
+	int buf_stale;		/* ...if not up to date */
+};
+
+
+/* A run of an object's indices, with the vertices it uses and their
+ * bounding box (for frustum culling) */
+typedef struct ogl_meshlet_struct ogl_meshlet;
+struct ogl_meshlet_struct {
+	int i0, num_indices;	/* Indices [i0, i0 + num_indices) */
+	int v0, v1;		/* use vertices [v0, v1) */
+	point min, max;		/* Unwarped bounds */
+};
+
+
 /* OpenGL object definition */
 typedef struct ogl_object_struct ogl_object;
 struct ogl_object_struct {
@@ -273,15 +408,85 @@ struct ogl_object_struct {
 	int		num_vertices;
         point		*vertices0;	/* Original, unwarped geometry */
 	point		*normals0;
+	float		*soa0;		/* Same, as x/y/z/nx/ny/nz streams */
+	int		soa_stride;	/* Floats per stream (padded) */
+	point		*vertices_lc;	/* Lorentz-contracted geometry, */
+	point		*normals_lc;	/* cached by the warp engine */
+	float		*soa_lc;	/* (or as streams, for SIMD) */
+	double		lc_gamma;	/* ...for this LC_gamma (0 == none) */
 	rgb_color	color0;
 	ogl_point	*iarrays;	/* C4F+N3F+V3F interleaved arrays */
 	int		num_indices;
 	unsigned int	*indices;
+	unsigned int	index_buf;	/* GL buffer object with the indices */
+	int		orig_num_vertices; /* Before strip_ogl_object( ) */
+	int		orig_num_indices;  /* (0 == not converted) */
+	int		orig_cache_misses; /* Before reorder_ogl_object( ) */
+	ogl_meshlet	*meshlets;	/* Built on demand (see */
+	int		num_meshlets;	/* update_ogl_object_meshlets( )) */
 	int		pre_dlist;	/* OGL display list executed before... */
 	int		post_dlist;	/* ...and after drawing the object */
 };
 
 
+/* Per-frame constants of the warp engine, shared by its kernels */
+typedef struct warp_params_struct warp_params;
+struct warp_params_struct {
+	double LC_gamma;
+	double OD_v, OD_v2, OD_v2_min_C2;
+	double OD_v_over_C, OD_inv_gamma2; /* For the float solve */
+	double DS_v_over_C, DS_gamma;
+	double HE_v_over_C, HE_gamma;
+	double real_x;		/* "Real" x-position of the vehicle */
+	point cam_pos;
+	const float *interp_lut1; /* Normal interpolation tables */
+	const float *interp_lut2;
+	const float *dgamma_lut;
+	float dgamma_exp;	/* (what dgamma_lut raises to) */
+	int dgamma_correct;
+	int effects;		/* WARP_FX_* bits of the effects to apply */
+};
+
+
+/* Everything a warp depends on, so that warps with different settings can
+ * run side by side. warp( ) keeps one of these for the user interface */
+typedef struct warp_context_struct warp_context;
+struct warp_context_struct {
+	/* Effect strengths (0 == off, 1 == full) */
+	float percent_contraction;
+	float percent_deformation;
+	float percent_dopplershift;
+	float percent_headlight;
+	double velocity;
+	double sim_time;	/* Simulation time (cf. cur_time_t) */
+	int dgamma_correct;
+	const float *dgamma_lut;
+	float dgamma_exp;
+	warp_params wp;		/* Constants used by the last warp_run( ) */
+};
+
+
+/* Warped vehicle geometry, shared by all cameras warped with the same
+ * constants (i.e. from the same position) */
+typedef struct warped_view_struct warped_view;
+struct warped_view_struct {
+	ogl_point **iarrays;	/* One array per vehicle object, NULL-terminated */
+	warp_params key;	/* What it was warped with */
+	int num_cams;		/* Number of cameras using it */
+	unsigned int serial;	/* Changes whenever iarrays do */
+	/* Per object, per WARP_CULL_BLOCK vertices: warped yet? (blocks
+	 * out of every camera's view are left alone, see WARP_CULL) */
+	unsigned char **blocks;
+	/* For extrapolation while dragging (see WARP_INTERACTIVE): per
+	 * vertex d(warped x)/d(camera position), as of an exact warp with
+	 * base, from base_dist away from the vehicle (0 == no gradients) */
+	point **grads;
+	warp_params base;
+	float base_dist;
+	int extrapolated;	/* Flag: is key past base? */
+};
+
+
 /* Camera state container */
 typedef struct camera_struct camera;
 struct camera_struct {
@@ -296,6 +501,12 @@ struct camera_struct {
 	float far_clip;
 	GtkWidget *window_w;	/* Associated window widget */
 	GtkWidget *ogl_w;	/* Associated GL widget (viewport) */
+	warped_view *view;	/* Vehicle geometry as seen from pos */
+	warped_view *next_view;	/* Being warped ahead for the next frame */
+	unsigned char **visible; /* Per object, per meshlet: to be drawn? */
+	unsigned int vbuf;	/* GL buffer object the view is uploaded to, */
+	unsigned int vbuf_serial; /* ...as of this view serial */
+	int next_ready : 1;	/* Flag: is next_view due to be shown? */
 	int redraw : 1;		/* Flag: does viewport want a redraw? */
 };
 
@@ -335,9 +546,13 @@ extern camera **usr_cams;
 extern int num_cams;
 extern int cur_cam;
 extern camera out_cam;
+extern int split_view;
 extern int advanced_interface;
+extern int headless;
 extern int dgamma_correct;
 extern float dgamma_lut[];
+extern float dgamma_exp;
+extern int shader_dgamma;
 extern float mouse_sens;
 
 /* Language-specific strings */
@@ -376,6 +591,11 @@ int command( const char *input );
 ogl_object *alloc_ogl_object( int num_vertices, int num_indices );
 int calc_ogl_object_memusage( int num_vertices, int num_indices );
 void free_ogl_object( ogl_object *obj );
+void update_ogl_object_soa( ogl_object *obj );
+void update_ogl_object_meshlets( ogl_object *obj );
+void reorder_ogl_object( ogl_object *obj );
+int calc_cache_misses( ogl_object *obj );
+void strip_ogl_object( ogl_object *obj );
 void clear_all_objects( void);
 void rotate_all_objects( int direction );
 void rotate_xyz( int action, float *x, float *y, float *z, float x0, float y0, float z0 );
@@ -427,6 +647,12 @@ GtkWidget *add_label( GtkWidget *parent_w, const char *label_text );
 GtkWidget *add_pixmap( GtkWidget *parent_w, GtkWidget *parent_window_w, char **xpm_data );
 void assign_icon( GtkWidget *window_w, char **xpm_data );
 
+/* image.c */
+int image_format( const char *filename );
+image_file *image_open( const char *filename, int width, int height );
+int image_write_rows( image_file *img, const unsigned char *rows, int stride, int num_rows );
+int image_close( image_file *img );
+
 /* importobjs.c */
 int import_objects( const char *filename );
 
@@ -463,6 +689,7 @@ void menu_Camera_InfoDisplay_toggles( GtkWidget *widget, const int *message );
 void menu_Camera_Background_select( GtkWidget *widget, const int *color_id );
 void menu_Camera_GraphicsMode_select( GtkWidget *widget, const int *message );
 void menu_Camera_Spawn( GtkWidget *widget, void *dummy );
+void menu_Camera_SplitView( GtkWidget *widget, void *dummy );
 void menu_Camera_Close( GtkWidget *widget_to_kill, void *dummy );
 void dialog_Help_Overview( GtkWidget *widget, int *message );
 void dialog_Help_Controls( GtkWidget *widget, int *message );
@@ -471,6 +698,7 @@ void dialog_Help_About( GtkWidget *widget, int *message );
 /* misc.c */
 void *xmalloc( size_t size );
 void *xrealloc( void *block, size_t size );
+void *xmalloc_aligned( size_t size, size_t alignment );
 char *xstrdup( const char *str );
 void xfree( void *block );
 int file_exists( const char *filename );
@@ -492,14 +720,51 @@ void ogl_initialize( GtkWidget *ogl_w, void *nothing );
 int ogl_resize( GtkWidget *ogl_w, GdkEventConfigure *ev_config, void *nothing );
 int ogl_refresh( GtkWidget *ogl_w, GdkEventExpose *ev_expose, void *nothing );
 void ogl_draw( int cam_id );
+void ogl_draw_tile( int x, int y, int width, int height, int warp_it );
+void ogl_split_layout( void );
+int ogl_split_pane_at( int x, int y );
+void ogl_draw_split( void );
+void ogl_release_buffers( camera *cam );
+int ogl_buffer_objects( void );
+void ogl_show_upload_stats( void );
 void ogl_draw_string( const void *data, int message, int size );
 void ogl_blank( int cam_id, const char *blank_message );
 GtkWidget *ogl_make_widget( void);
 
+#ifdef WITH_HEADLESS_RENDERER
+/* export.c */
+int export_animation( const char *obj_file, const char *out_file, int width, int height, const float *view, const float *anim, float fps );
+
+/* render.c */
+camera *render_begin( const char *obj_file, int width, int height, const float *view, int tiled );
+void render_end( void );
+int render_headless( const char *obj_file, const char *image_file, int width, int height, const float *view );
+#endif /* WITH_HEADLESS_RENDERER */
+
 /* warp.c */
 int warp( int message, void *data );
 void warp_point( point *vertex, point *normal, point *cam_pos );
+void warp_points( point *vertices, point *normals, int num_points, point *cam_pos );
+void warp_context_init( warp_context *ctx );
+void warp_run( warp_context *ctx, ogl_object **objs, int num_objs, point *cam_pos, ogl_point **out_buffers );
+void warp_run_velocities( warp_context *ctx, ogl_object **objs, int num_objs, point *cam_pos, int num_velocities, const double *velocities, const double *sim_times, ogl_point **out_buffers );
+double warp_deformation_velocity( const warp_context *ctx );
 void warp_time( float x0, float x1, double value, int message );
 double lorentz_factor( double v );
 
+/* warp_pool.c */
+void warp_pool_init( int n );
+int warp_pool_get_num_threads( void );
+void warp_pool_run( ogl_object **objs, int num_objs, void (*func)( int obj_id, int v0, int v1, void *data ), void *data );
+void warp_pool_run_async( ogl_object **objs, int num_objs, void (*func)( int obj_id, int v0, int v1, void *data ), void *data );
+void warp_pool_wait( void );
+
+#ifdef WARP_SIMD_X86
+/* warp_simd.c */
+int warp_simd_supported( void );
+void warp_kernel_avx2( ogl_object *obj, ogl_point *out, int v0, int v1, const warp_params *wp );
+void warp_kernel_avx2_multi( ogl_object *obj, const float *soa, ogl_point **outs, int v0, int v1, const warp_params *wps, int num_wps, int effects );
+void warp_contract_avx2( ogl_object *obj, int v0, int v1, double LC_gamma );
+#endif /* WARP_SIMD_X86 */
+
 /* end lightspeed.h */
@@ -43,7 +43,7 @@ const char *STR_copyright_ARG		= "Copyright (C) %d by %s";
 /**** COMMAND-LINE INTERFACE ****/
 
 /* %s = executable name */
-const char *STR_CLI_usage_ARG		= "usage: %s [-hsa] [object]";
+const char *STR_CLI_usage_ARG		= "usage: %s [-hsa] [-r file [-v velocity] [-c phi,theta,dist] [-g WxH] [-x x0,x1,secs [-f fps]]] [object]";
 struct option_desc STRS_CLI_options[] 	= {
 	{ 'h', "help", "Print this help screen" },
 #ifdef DEF_ADVANCED_INTERFACE
@@ -53,9 +53,15 @@ struct option_desc STRS_CLI_options[] 	= {
 	{ 's', "simple", "Use simple interface (default)" },
 	{ 'a', "advanced", "Use more advanced interface" },
 #endif /* not DEF_ADVANCED_INTERFACE */
+	{ 'r', "render", "Render to an image file (.png or .tif) without a display (the GTK+ libraries must still be installed)" },
+	{ 'v', "velocity", "Velocity in m/s, or as a fraction of c (e.g. 0.9c)" },
+	{ 'c', "camera", "Camera angles (degrees) and distance for --render" },
+	{ 'g', "size", "Image size for --render (e.g. 3840x2160)" },
+	{ 'x', "animate", "Export an animation loop (as in Objects/Animation) to numbered images, or .y4m video" },
+	{ 'f', "fps", "Frame rate for --animate (default 30)" },
 	{ '\0', "object", "3D file to load on startup (.3DS or .LWO)" }
 };
-const char *STR_CLI_option_chars	= "hsa";
+const char *STR_CLI_option_chars	= "hsar:v:c:g:x:f:";
 
 /**** MENUS ****/
 
@@ -91,6 +97,7 @@ const char *STR_MNU_Info_display	= "Info display";
 const char *STR_MNU_Background		= "Background";
 const char *STR_MNU_Graphics_mode	= "Graphics mode";
 const char *STR_MNU_Spawn_camera	= "Spawn camera";
+const char *STR_MNU_Split_view		= "Split view";
 const char *STR_MNU_Close		= "Close";
 
 /* Camera->Lens submenu */
@@ -284,7 +291,7 @@ void setup_gettext() {
 	/**** COMMAND-LINE INTERFACE ****/
 
 	/* %s = executable name */
-	STR_CLI_usage_ARG			= _("usage: %s [-hsa] [object]");
+	STR_CLI_usage_ARG			= _("usage: %s [-hsa] [-r file [-v velocity] [-c phi,theta,dist] [-g WxH] [-x x0,x1,secs [-f fps]]] [object]");
 	struct option_desc STRS_CLI_options[]	= {
 		{ 'h', "help", _("Print this help screen") },
 	#ifdef DEF_ADVANCED_INTERFACE
@@ -294,9 +301,15 @@ void setup_gettext() {
 		{ 's', "simple", _("Use simple interface (default)") },
 		{ 'a', "advanced", _("Use more advanced interface") },
 	#endif /* not DEF_ADVANCED_INTERFACE */
+		{ 'r', "render", _("Render to an image file (.png or .tif) without a display (the GTK+ libraries must still be installed)") },
+		{ 'v', "velocity", _("Velocity in m/s, or as a fraction of c (e.g. 0.9c)") },
+		{ 'c', "camera", _("Camera angles (degrees) and distance for --render") },
+		{ 'g', "size", _("Image size for --render (e.g. 3840x2160)") },
+		{ 'x', "animate", _("Export an animation loop (as in Objects/Animation) to numbered images, or .y4m video") },
+		{ 'f', "fps", _("Frame rate for --animate (default 30)") },
 		{ '\0', "object", _("3D file to load on startup (.3DS or .LWO)") }
 	};
-	STR_CLI_option_chars			= "hsa";
+	STR_CLI_option_chars			= "hsar:v:c:g:x:f:";
 
 	/**** MENUS ****/
 
@@ -332,6 +345,7 @@ void setup_gettext() {
 	STR_MNU_Background			= _("Background");
 	STR_MNU_Graphics_mode			= _("Graphics mode");
 	STR_MNU_Spawn_camera			= _("Spawn camera");
+	STR_MNU_Split_view			= _("Split view");
 	STR_MNU_Close				= _("Close");
 
 	/* Camera->Lens submenu */
@@ -52,6 +52,7 @@ extern const char *STR_MNU_Info_display;
 extern const char *STR_MNU_Background;
 extern const char *STR_MNU_Graphics_mode;
 extern const char *STR_MNU_Spawn_camera;
+extern const char *STR_MNU_Split_view;
 extern const char *STR_MNU_Close;
 extern const char *STR_MNU_Custom;
 extern const char *STR_MNU_Active;
@@ -219,6 +219,8 @@ void add_Camera_menu( GtkWidget *menu_bar_w, GtkWidget *window_w )
 			add_separator( menu_w );
 			menu_item_w = add_menu_item( menu_w, STR_MNU_Spawn_camera, menu_Camera_Spawn, NULL );
 			keybind( menu_item_w, "S" );
+			menu_item_w = add_check_menu_item( menu_w, STR_MNU_Split_view, FALSE, menu_Camera_SplitView, NULL );
+			keybind( menu_item_w, "V" );
 		}
 	}
 	else {
@@ -1114,7 +1114,36 @@ menu_Camera_Spawn( GtkWidget *widget, void *dummy )
 	/* Attach keybindings */
 	keybind( cam_window_w, NULL );
 
-	gtk_widget_show( cam_window_w ); /* Ready for action! */
+	/* (in split view, the camera gets a pane of the primary viewport
+	 * instead, and its window stays hidden until that is turned off) */
+	if (split_view) {
+		ogl_split_layout( );
+		queue_redraw( -1 );
+	}
+	else
+		gtk_widget_show( cam_window_w ); /* Ready for action! */
+}
+
+
+/* Camera / Split view
+ * Draws all cameras side by side in the main window, in one go, rather
+ * than each in a window of its own */
+void
+menu_Camera_SplitView( GtkWidget *widget, void *dummy )
+{
+	int i;
+
+	split_view = GTK_CHECK_MENU_ITEM(widget)->active;
+	for (i = 1; i < num_cams; i++) {
+		if (split_view)
+			gtk_widget_hide( usr_cams[i]->window_w );
+		else
+			gtk_widget_show( usr_cams[i]->window_w );
+	}
+	ogl_split_layout( );
+
+	/* Redraw everything */
+	queue_redraw( -1 );
 }
 
 
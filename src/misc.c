@@ -68,6 +68,23 @@ xrealloc( void *block, size_t size )
 }
 
 
+/* xmalloc( ) for blocks that must start on an alignment boundary
+ * (e.g. for SIMD loads). Such blocks are freed with xfree( ) as usual */
+void *
+xmalloc_aligned( size_t size, size_t alignment )
+{
+	void *block;
+
+	if (posix_memalign( &block, alignment, size ) != 0)
+		crash( "Insufficient memory" );
+#ifdef WITH_TRACKMEM
+	trackmem_malloc( block, size );
+#endif
+
+	return block;
+}
+
+
 char *
 xstrdup( const char *str )
 {
@@ -311,6 +328,7 @@ calc_dgamma_lut( float dgamma )
 	int i;
 
 	k = 1.0 / dgamma;
+	dgamma_exp = k;
 	for (i = 0; i <= LUT_RES; i++) {
 		x = (float)i / LUT_RES;
 		dgamma_lut[i] = pow( x, k );
@@ -26,6 +26,150 @@
 #include "lightspeed.h"
 
 
+#ifdef WITH_BUFFER_OBJECTS
+/* Flag: does the GL (the viewports', or the headless one) take buffer
+ * objects? (see ogl_initialize( )) */
+static int use_buffer_objects = FALSE;
+#endif
+/* Vertex data handed to the GL for the viewports, and the number of views
+ * drawn and uploaded (for PERFSTATS) */
+static double bytes_uploaded = 0.0;
+static int num_views_drawn = 0;
+static int num_views_uploaded = 0;
+/* Part of the off-screen image that ogl_draw( -1 ) draws, if not all of
+ * it (see ogl_draw_tile( )), and whether the vehicle is warped for it */
+static int tile_x, tile_y;
+static int tile_width = 0, tile_height = 0;
+static int tile_warp = TRUE;
+/* Flag: is ogl_draw( ) drawing a pane of the split view? (see
+ * ogl_draw_split( )) */
+static int split_pass = FALSE;
+
+#ifdef WITH_SHADER_RENDERER
+/* Flag: is the vehicle drawn with vehicle_program? (see ogl_initialize( )) */
+static int use_shaders = FALSE;
+static unsigned int vehicle_program = 0;
+/* Locations of its per-draw uniforms */
+static int u_modelview, u_projection, u_dgamma_exp;
+/* Vertex buffer that ogl_draw( -1 ) draws the vehicle from */
+static unsigned int offscreen_vbuf = 0;
+
+/* Lighting is per vertex, the same as the fixed-function pipeline does it
+ * with the setup in ogl_initialize( ): a light at the eye, ambient and
+ * diffuse only. Display gamma goes on the base color before lighting
+ * (1.0 == none), as warp( ) does it for the fixed-function path. (The
+ * viewports' contexts are compatibility ones, so the buffer bindings go
+ * in the default vertex array object) */
+static const char *vehicle_vertex_shader =
+	"#version 330 core\n"
+	"layout(location = 0) in vec3 position;\n"
+	"layout(location = 1) in vec3 normal;\n"
+	"layout(location = 2) in vec4 color;\n"
+	"uniform mat4 modelview;\n"
+	"uniform mat4 projection;\n"
+	"uniform vec3 ambient;\n"
+	"uniform vec3 diffuse;\n"
+	"uniform float dgamma_exp;\n"
+	"out vec4 lit_color;\n"
+	"void main( )\n"
+	"{\n"
+	"	vec4 eye = modelview * vec4( position, 1.0 );\n"
+	"	vec3 n = mat3( modelview ) * normal;\n"
+	"	float d = max( dot( n, normalize( - eye.xyz ) ), 0.0 );\n"
+	"	vec3 base = pow( color.rgb, vec3( dgamma_exp ) );\n"
+	"	lit_color = vec4( min( base * (ambient + d * diffuse), 1.0 ), color.a );\n"
+	"	gl_Position = projection * eye;\n"
+	"}\n";
+
+static const char *vehicle_fragment_shader =
+	"#version 330 core\n"
+	"in vec4 lit_color;\n"
+	"out vec4 frag_color;\n"
+	"void main( )\n"
+	"{\n"
+	"	frag_color = lit_color;\n"
+	"}\n";
+
+/* Conversions to the normalized fixed point of ogl_packed_point
+ * (rounding to nearest) */
+#define PACK_UNORM8(f)	((unsigned char)(MIN(1.0, MAX(0.0, (f))) * 255.0 + 0.5))
+#define PACK_SNORM10(f)	((unsigned int)((int)(MIN(1.0, MAX(-1.0, (f))) * 511.0 + 511.5) - 511) & 0x3FF)
+#endif /* WITH_SHADER_RENDERER */
+
+
+#ifdef WITH_SHADER_RENDERER
+/* Compiles one of vehicle_program's shaders. Returns 0 (after saying why)
+ * if the GL won't take it */
+static unsigned int
+compile_shader( unsigned int type, const char *source )
+{
+	unsigned int shader;
+	int ok;
+	char log[1024];
+
+	shader = glCreateShader( type );
+	glShaderSource( shader, 1, &source, NULL );
+	glCompileShader( shader );
+	glGetShaderiv( shader, GL_COMPILE_STATUS, &ok );
+	if (!ok) {
+		glGetShaderInfoLog( shader, sizeof(log), NULL, log );
+		printf( "ERROR: Cannot compile vehicle shader:\n%s\n", log );
+		fflush( stdout );
+		glDeleteShader( shader );
+		return 0;
+	}
+
+	return shader;
+}
+
+
+/* Builds vehicle_program, with the given ambient and diffuse light (RGB).
+ * Returns FALSE if it can't be had */
+static int
+init_shaders( const float *ambient, const float *diffuse )
+{
+	unsigned int vert, frag;
+	int ok;
+	char log[1024];
+
+	vert = compile_shader( GL_VERTEX_SHADER, vehicle_vertex_shader );
+	frag = compile_shader( GL_FRAGMENT_SHADER, vehicle_fragment_shader );
+	if ((vert == 0) || (frag == 0)) {
+		glDeleteShader( vert );
+		glDeleteShader( frag );
+		return FALSE;
+	}
+
+	vehicle_program = glCreateProgram( );
+	glAttachShader( vehicle_program, vert );
+	glAttachShader( vehicle_program, frag );
+	glLinkProgram( vehicle_program );
+	/* (they go when the program does) */
+	glDeleteShader( vert );
+	glDeleteShader( frag );
+	glGetProgramiv( vehicle_program, GL_LINK_STATUS, &ok );
+	if (!ok) {
+		glGetProgramInfoLog( vehicle_program, sizeof(log), NULL, log );
+		printf( "ERROR: Cannot link vehicle shader:\n%s\n", log );
+		fflush( stdout );
+		glDeleteProgram( vehicle_program );
+		vehicle_program = 0;
+		return FALSE;
+	}
+
+	u_modelview = glGetUniformLocation( vehicle_program, "modelview" );
+	u_projection = glGetUniformLocation( vehicle_program, "projection" );
+	u_dgamma_exp = glGetUniformLocation( vehicle_program, "dgamma_exp" );
+	glUseProgram( vehicle_program );
+	glUniform3fv( glGetUniformLocation( vehicle_program, "ambient" ), 1, ambient );
+	glUniform3fv( glGetUniformLocation( vehicle_program, "diffuse" ), 1, diffuse );
+	glUseProgram( 0 );
+
+	return TRUE;
+}
+#endif /* WITH_SHADER_RENDERER */
+
+
 /* Initialize OpenGL state
  * (will be connected to the GL widget's "realize" signal) */
 void
@@ -36,6 +180,10 @@ ogl_initialize( GtkWidget *ogl_w, void *nothing )
 	float light0_specular[] = { 1.0, 1.0, 1.0, 1.0 };
 	float light_model_ambient[] = { 0.5, 0.5, 0.5, 1.0 };
 	float light_pos[] = { 0.0, 0.0, 0.0, 1.0 };
+#ifdef WITH_BUFFER_OBJECTS
+	const char *version;
+	int major = 1, minor = 1;
+#endif
 	int on_screen = TRUE;
 
 	if (ogl_w == NULL)
@@ -68,10 +216,30 @@ ogl_initialize( GtkWidget *ogl_w, void *nothing )
 	glLoadIdentity( );
 
 	/* Initialize ogl_draw_string for primary viewport and pixmap buffers
-	 * (other viewports will get this via shared context) */
-	if ((assoc_cam_id( ogl_w ) == 0) || !on_screen)
+	 * (other viewports will get this via shared context). There are no
+	 * fonts to be had without a display */
+	if (((assoc_cam_id( ogl_w ) == 0) || !on_screen) && !headless)
 		ogl_draw_string( NULL, INITIALIZE, NIL );
 
+#ifdef WITH_BUFFER_OBJECTS
+	/* Buffer objects are core as of OpenGL 1.5 (the viewports share
+	 * them, but not the off-screen pixmap buffer), and the shaders we
+	 * use as of 3.3. Headless, the off-screen context is the only one */
+	if ((on_screen && (assoc_cam_id( ogl_w ) == 0)) || headless) {
+		version = (const char *)glGetString( GL_VERSION );
+		if (version != NULL)
+			sscanf( version, "%d.%d", &major, &minor );
+		use_buffer_objects = (major > 1) || (minor >= 5);
+#ifdef WITH_SHADER_RENDERER
+		use_shaders = (major > 3) || ((major == 3) && (minor >= 3));
+		if (use_shaders)
+			use_shaders = init_shaders( light_model_ambient, light0_diffuse );
+		/* (and then warp( ) leaves display gamma to them) */
+		shader_dgamma = use_shaders;
+#endif
+	}
+#endif
+
 	if (on_screen) {
 		/* Call ogl_resize( ) to finish viewport initialization */
 		ogl_resize( ogl_w, NULL, NULL );
@@ -106,6 +274,9 @@ ogl_resize( GtkWidget *ogl_w, GdkEventConfigure *ev_config, void *nothing )
 	i = assoc_cam_id( ogl_w );
 	usr_cams[i]->width = width;
 	usr_cams[i]->height = height;
+	/* (or, in split view, the size of each camera's pane) */
+	if (split_view && (i == 0))
+		ogl_split_layout( );
 
 	/* Recalibrate framerate */
 	profile( PROFILE_FRAMERATE_RESET );
@@ -140,20 +311,370 @@ ogl_refresh( GtkWidget *ogl_w, GdkEventExpose *ev_expose, void *nothing )
 }
 
 
+#ifdef WITH_SHADER_RENDERER
+/* Fills the bound vertex buffer with the vehicle objects' warped vertices
+ * (arrays[o] for object o, or their own iarrays if arrays is NULL), packed
+ * for vehicle_program. Returns the size of it all in bytes */
+static long
+upload_packed( ogl_point **arrays )
+{
+	ogl_packed_point *out;
+	const ogl_point *pnt;
+	long size = 0;
+	int o, v;
+
+	for (o = 0; o < num_vehicle_objs; o++)
+		size += vehicle_objs[o]->num_vertices * sizeof(ogl_packed_point);
+	glBufferData( GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW );
+	out = glMapBufferRange( GL_ARRAY_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT );
+	if (out == NULL)
+		return 0;
+
+	for (o = 0; o < num_vehicle_objs; o++) {
+		if (arrays != NULL)
+			pnt = arrays[o];
+		else
+			pnt = vehicle_objs[o]->iarrays;
+		for (v = 0; v < vehicle_objs[o]->num_vertices; v++) {
+			out->x = pnt->x;
+			out->y = pnt->y;
+			out->z = pnt->z;
+			out->normal = PACK_SNORM10(pnt->nx) | (PACK_SNORM10(pnt->ny) << 10) | (PACK_SNORM10(pnt->nz) << 20);
+			out->r = PACK_UNORM8(pnt->r);
+			out->g = PACK_UNORM8(pnt->g);
+			out->b = PACK_UNORM8(pnt->b);
+			out->a = PACK_UNORM8(pnt->a);
+			++pnt;
+			++out;
+		}
+	}
+	glUnmapBuffer( GL_ARRAY_BUFFER );
+
+	return size;
+}
+#endif /* WITH_SHADER_RENDERER */
+
+
+#ifdef WITH_BUFFER_OBJECTS
+/* Binds the camera's vertex buffer, first uploading its warped view to it
+ * if that has changed since. The old contents are orphaned, so that the GL
+ * needn't wait for any draw still using them. Cameras that share a warped
+ * view use the buffer of the first of them (the contexts share buffers) */
+static void
+upload_view( camera *cam )
+{
+	long size, offset;
+	int o;
+
+	for (o = 0; usr_cams[o]->view != cam->view; o++);
+	cam = usr_cams[o];
+
+	if (cam->vbuf == 0)
+		glGenBuffers( 1, &cam->vbuf );
+	glBindBuffer( GL_ARRAY_BUFFER, cam->vbuf );
+	if (cam->vbuf_serial == cam->view->serial)
+		return;
+
+#ifdef WITH_SHADER_RENDERER
+	if (use_shaders)
+		offset = upload_packed( cam->view->iarrays );
+	else
+#endif
+	{
+		size = 0;
+		for (o = 0; o < num_vehicle_objs; o++)
+			size += vehicle_objs[o]->num_vertices * sizeof(ogl_point);
+		glBufferData( GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW );
+		offset = 0;
+		for (o = 0; o < num_vehicle_objs; o++) {
+			size = vehicle_objs[o]->num_vertices * sizeof(ogl_point);
+			glBufferSubData( GL_ARRAY_BUFFER, offset, size, cam->view->iarrays[o] );
+			offset += size;
+		}
+	}
+	cam->vbuf_serial = cam->view->serial;
+	bytes_uploaded += (double)offset;
+	++num_views_uploaded;
+}
+
+
+/* Binds an object's index buffer, creating it the first time around
+ * (the indices never change, so they stay on the GL side) */
+static void
+bind_indices( ogl_object *obj )
+{
+	long size;
+
+	if (obj->index_buf != 0) {
+		glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, obj->index_buf );
+		return;
+	}
+	size = obj->num_indices * sizeof(unsigned int);
+	glGenBuffers( 1, &obj->index_buf );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, obj->index_buf );
+	glBufferData( GL_ELEMENT_ARRAY_BUFFER, size, obj->indices, GL_STATIC_DRAW );
+	bytes_uploaded += (double)size;
+}
+#endif /* WITH_BUFFER_OBJECTS */
+
+
+#ifdef GL_VERSION_1_1
+/* Draws the meshlets of an object flagged in visible[ ] (see WARP_CULL),
+ * with a single call for each run of consecutive ones (or, for the shader
+ * renderer, one for all of them, its vertices counting from base_vertex).
+ * indices is where the object's indices are, or NULL for the bound index
+ * buffer */
+static void
+draw_meshlets( ogl_object *obj, unsigned int *indices, const unsigned char *visible, int base_vertex )
+{
+#ifdef WITH_SHADER_RENDERER
+	static int *counts = NULL;
+	static const void **firsts = NULL;
+	static int *bases = NULL;
+	static int max_runs = 0;
+	int num_runs = 0;
+#endif
+	ogl_meshlet *ml;
+	int v0, v1, count;
+	int m, n;
+
+#ifdef WITH_SHADER_RENDERER
+	if (use_shaders && (obj->num_meshlets > max_runs)) {
+		max_runs = obj->num_meshlets;
+		counts = xrealloc( counts, max_runs * sizeof(int) );
+		firsts = xrealloc( firsts, max_runs * sizeof(void *) );
+		bases = xrealloc( bases, max_runs * sizeof(int) );
+	}
+#endif
+
+	for (m = 0; m < obj->num_meshlets; m = n) {
+		n = m + 1;
+		if (!visible[m])
+			continue;
+		ml = &obj->meshlets[m];
+		v0 = ml->v0;
+		v1 = ml->v1;
+		for (; (n < obj->num_meshlets) && visible[n]; n++) {
+			v0 = MIN(v0, obj->meshlets[n].v0);
+			v1 = MAX(v1, obj->meshlets[n].v1);
+		}
+		/* (runs of strip meshlets join up, as they overlap) */
+		count = obj->meshlets[n - 1].i0 + obj->meshlets[n - 1].num_indices - ml->i0;
+		if (count <= 0)
+			continue;
+#ifdef WITH_SHADER_RENDERER
+		if (use_shaders) {
+			counts[num_runs] = count;
+			firsts[num_runs] = (char *)indices + ml->i0 * sizeof(unsigned int);
+			bases[num_runs] = base_vertex;
+			++num_runs;
+			continue;
+		}
+#endif
+#ifdef GL_VERSION_1_2
+		glDrawRangeElements( obj->type, v0, v1 - 1, count, GL_UNSIGNED_INT, (char *)indices + ml->i0 * sizeof(unsigned int) );
+#else
+		glDrawElements( obj->type, count, GL_UNSIGNED_INT, (char *)indices + ml->i0 * sizeof(unsigned int) );
+#endif
+	}
+#ifdef WITH_SHADER_RENDERER
+	if (num_runs > 0)
+		glMultiDrawElementsBaseVertex( obj->type, counts, GL_UNSIGNED_INT, firsts, num_runs, bases );
+#endif
+}
+#endif /* GL_VERSION_1_1 */
+
+
+/* Draws the vehicle objects as seen by cam (its warped view and visible
+ * meshlets if drawing_to_screen, or else the objects' own iarrays) */
+static void
+draw_vehicle( camera *cam, int drawing_to_screen )
+{
+	ogl_object *obj;
+	ogl_point *pnts;
+	unsigned int *indices;
+	unsigned char *visible = NULL;
+#ifdef WITH_BUFFER_OBJECTS
+	long offset = 0;
+#endif
+	int use_buffers = FALSE;
+	int o;
+#ifndef GL_VERSION_1_1
+	int i, v;
+#endif
+
+	/* Vertex data goes to the GL in a buffer object when it changes,
+	 * or else as client-side arrays with every draw */
+#ifdef WITH_BUFFER_OBJECTS
+	use_buffers = drawing_to_screen && use_buffer_objects;
+	if (use_buffers)
+		upload_view( cam );
+#endif
+	if (drawing_to_screen) {
+		if (!use_buffers) {
+			for (o = 0; o < num_vehicle_objs; o++) {
+				obj = vehicle_objs[o];
+				bytes_uploaded += (double)(obj->num_vertices * sizeof(ogl_point));
+				bytes_uploaded += (double)(obj->num_indices * sizeof(unsigned int));
+			}
+		}
+		++num_views_drawn;
+	}
+
+	/* Draw all vehicle objects */
+	for (o = 0; o < num_vehicle_objs; o++) {
+		obj = vehicle_objs[o];
+		if (drawing_to_screen) {
+			pnts = cam->view->iarrays[o];
+			visible = cam->visible[o];
+		}
+		else
+			pnts = obj->iarrays;
+		indices = obj->indices;
+#ifdef WITH_BUFFER_OBJECTS
+		if (use_buffers) {
+			/* (offsets into the bound buffers now) */
+			pnts = (ogl_point *)offset;
+			offset += obj->num_vertices * sizeof(ogl_point);
+			bind_indices( obj );
+			indices = NULL;
+		}
+#endif
+
+		/* Execute "before" display list, if there is one */
+		if (obj->pre_dlist != 0)
+			glCallList( obj->pre_dlist );
+
+#ifdef GL_VERSION_1_1
+		glInterleavedArrays( GL_C4F_N3F_V3F, sizeof(ogl_point), pnts );
+		if (visible != NULL)
+			draw_meshlets( obj, indices, visible, 0 );
+		else {
+#ifdef GL_VERSION_1_2
+			glDrawRangeElements( obj->type, 0, obj->num_vertices - 1, obj->num_indices, GL_UNSIGNED_INT, indices );
+#else
+			glDrawElements( obj->type, obj->num_indices, GL_UNSIGNED_INT, indices );
+#endif /* else GL_VERSION_1_2 */
+		}
+#else
+		/* Fine, we'll do this the old-fashioned way */
+		glBegin( obj->type );
+		for (i = 0; i < obj->num_indices; i++) {
+			v = obj->indices[i];
+			glColor4fv( &pnts[v].r );
+			glNormal3fv( &pnts[v].nx );
+			glVertex3fv( &pnts[v].x );
+		}
+		glEnd( );
+#endif /* else GL_VERSION_1_1 */
+
+		/* Execute "after" display list if there is one */
+		if (obj->post_dlist != 0)
+			glCallList( obj->post_dlist );
+	}
+
+#ifdef WITH_BUFFER_OBJECTS
+	if (use_buffers) {
+		glBindBuffer( GL_ARRAY_BUFFER, 0 );
+		glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+	}
+#endif
+}
+
+
+#ifdef WITH_SHADER_RENDERER
+/* Draws the vehicle objects as draw_vehicle( ) does, but with
+ * vehicle_program: all their vertices are in one buffer, and there is one
+ * draw call per object */
+static void
+draw_vehicle_shaded( camera *cam, int drawing_to_screen )
+{
+	ogl_object *obj;
+	float modelview[16], projection[16];
+	int base_vertex = 0;
+	int o;
+
+	if (drawing_to_screen) {
+		upload_view( cam );
+		++num_views_drawn;
+	}
+	else {
+		if (offscreen_vbuf == 0)
+			glGenBuffers( 1, &offscreen_vbuf );
+		glBindBuffer( GL_ARRAY_BUFFER, offscreen_vbuf );
+		/* (the vehicle is the same in every tile of an image) */
+		if (tile_warp)
+			upload_packed( NULL );
+	}
+
+	/* The fixed-function matrices are all set up by now */
+	glGetFloatv( GL_MODELVIEW_MATRIX, modelview );
+	glGetFloatv( GL_PROJECTION_MATRIX, projection );
+	glUseProgram( vehicle_program );
+	glUniformMatrix4fv( u_modelview, 1, GL_FALSE, modelview );
+	glUniformMatrix4fv( u_projection, 1, GL_FALSE, projection );
+	glUniform1f( u_dgamma_exp, dgamma_correct ? dgamma_exp : 1.0 );
+
+	glVertexAttribPointer( 0, 3, GL_FLOAT, GL_FALSE, sizeof(ogl_packed_point), (void *)offsetof(ogl_packed_point, x) );
+	glVertexAttribPointer( 1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(ogl_packed_point), (void *)offsetof(ogl_packed_point, normal) );
+	glVertexAttribPointer( 2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ogl_packed_point), (void *)offsetof(ogl_packed_point, r) );
+	glEnableVertexAttribArray( 0 );
+	glEnableVertexAttribArray( 1 );
+	glEnableVertexAttribArray( 2 );
+
+	for (o = 0; o < num_vehicle_objs; o++) {
+		obj = vehicle_objs[o];
+		bind_indices( obj );
+		if (obj->pre_dlist != 0)
+			glCallList( obj->pre_dlist );
+		if (drawing_to_screen && (cam->visible[o] != NULL))
+			draw_meshlets( obj, NULL, cam->visible[o], base_vertex );
+		else
+			glDrawElementsBaseVertex( obj->type, obj->num_indices, GL_UNSIGNED_INT, NULL, base_vertex );
+		if (obj->post_dlist != 0)
+			glCallList( obj->post_dlist );
+		base_vertex += obj->num_vertices;
+	}
+
+	glDisableVertexAttribArray( 0 );
+	glDisableVertexAttribArray( 1 );
+	glDisableVertexAttribArray( 2 );
+	glUseProgram( 0 );
+	glBindBuffer( GL_ARRAY_BUFFER, 0 );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+}
+#endif /* WITH_SHADER_RENDERER */
+
+
+/* Sets the GL's clear color to the background (display gamma corrected,
+ * as the vehicle is) */
+static void
+set_clear_color( void )
+{
+	float r,g,b;
+
+	r = background.r;
+	g = background.g;
+	b = background.b;
+	if (dgamma_correct) {
+		r = dgamma_lut[(int)(r * LUT_RES)];
+		g = dgamma_lut[(int)(g * LUT_RES)];
+		b = dgamma_lut[(int)(b * LUT_RES)];
+	}
+	glClearColor( r, g, b, 0.0 );
+}
+
+
 /* Redraws the viewport of the camera indicated by cam_id
  * A cam_id of -1 means we're drawing the primary view into a pixmap buffer */
 void
 ogl_draw( int cam_id )
 {
 	camera *cam;
-	ogl_object *obj;
-	float r,g,b;
 	float fr_x, fr_y;
+	float x0, x1, y0, y1;
 	int drawing_to_screen = TRUE;
-	int o, i, v;
-
-	i = 0; /* Avoid pesky "unused variable..." warnings */
-	v = 0; /* (if they come up-- see the #ifdef's) */
+	int warping_ahead;
 
 #ifdef SUPER_DEBUG
 	if (cam_id >= 0)
@@ -171,27 +692,26 @@ ogl_draw( int cam_id )
 	else
 		cam = usr_cams[cam_id];
 
-	/* Apply relativistic distortions for this view */
+	/* Apply relativistic distortions for this view (unless the
+	 * camera's warped geometry is still good) */
 	if (drawing_to_screen) {
 		profile( PROFILE_WARP_BEGIN );
-		warp( WARP_DISTORT, &cam->pos );
+		warp( WARP_DISTORT_CAMERA, cam );
+		/* (and leave out what it can't see) */
+		warp( WARP_CULL, cam );
 		profile( PROFILE_WARP_DONE );
 
 		profile( PROFILE_OGLDRAW_BEGIN );
-		gtk_gl_area_make_current( GTK_GL_AREA(cam->ogl_w) );
+		if (!split_pass) {
+			gtk_gl_area_make_current( GTK_GL_AREA(cam->ogl_w) );
+			/* (split view may have left a pane's viewport) */
+			glViewport( 0, 0, cam->width, cam->height );
+		}
 	}
-	else
+	else if (tile_warp)
 		warp( WARP_DISTORT, &cam->pos );
 
-	r = background.r;
-	g = background.g;
-	b = background.b;
-	if (dgamma_correct) {
-		r = dgamma_lut[(int)(r * LUT_RES)];
-		g = dgamma_lut[(int)(g * LUT_RES)];
-		b = dgamma_lut[(int)(b * LUT_RES)];
-	}
-	glClearColor( r, g, b, 0.0 );
+	set_clear_color( );
 	glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
 
 	/* Set view frustum (a.k.a. field of view) */
@@ -199,7 +719,16 @@ ogl_draw( int cam_id )
 	glLoadIdentity( );
 	fr_x = cam->near_clip * tan( RAD(cam->fov) / 2 );
 	fr_y = fr_x / ((float)cam->width / (float)cam->height);
-	glFrustum( - fr_x, fr_x, - fr_y, fr_y, cam->near_clip, cam->far_clip );
+	if (!drawing_to_screen && (tile_width > 0)) {
+		/* Just the tile's slice of the frustum */
+		x0 = fr_x * (2.0 * (float)tile_x / (float)cam->width - 1.0);
+		x1 = fr_x * (2.0 * (float)(tile_x + tile_width) / (float)cam->width - 1.0);
+		y0 = fr_y * (2.0 * (float)tile_y / (float)cam->height - 1.0);
+		y1 = fr_y * (2.0 * (float)(tile_y + tile_height) / (float)cam->height - 1.0);
+		glFrustum( x0, x1, y0, y1, cam->near_clip, cam->far_clip );
+	}
+	else
+		glFrustum( - fr_x, fr_x, - fr_y, fr_y, cam->near_clip, cam->far_clip );
 
 	/* (Re)initialize transformation matrix */
 	glMatrixMode( GL_MODELVIEW );
@@ -218,37 +747,12 @@ ogl_draw( int cam_id )
 	/* For wireframe mode, if active */
 	glLineWidth( 2 );
 
-	/* Draw all vehicle objects */
-	for (o = 0; o < num_vehicle_objs; o++) {
-		obj = vehicle_objs[o];
-
-		/* Execute "before" display list, if there is one */
-		if (obj->pre_dlist != 0)
-			glCallList( obj->pre_dlist );
-
-#ifdef GL_VERSION_1_1
-		glInterleavedArrays( GL_C4F_N3F_V3F, sizeof(ogl_point), obj->iarrays );
-#ifdef GL_VERSION_1_2
-		glDrawRangeElements( obj->type, 0, obj->num_vertices - 1, obj->num_indices, GL_UNSIGNED_INT, obj->indices );
-#else
-		glDrawElements( obj->type, obj->num_indices, GL_UNSIGNED_INT, obj->indices );
-#endif /* else GL_VERSION_1_2 */
-#else
-		/* Fine, we'll do this the old-fashioned way */
-		glBegin( obj->type );
-		for (i = 0; i < obj->num_indices; i++) {
-			v = obj->indices[i];
-			glColor4fv( &obj->iarrays[v].r );
-			glNormal3fv( &obj->iarrays[v].nx );
-			glVertex3fv( &obj->iarrays[v].x );
-		}
-		glEnd( );
-#endif /* else GL_VERSION_1_1 */
-
-		/* Execute "after" display list if there is one */
-		if (obj->post_dlist != 0)
-			glCallList( obj->post_dlist );
-	}
+#ifdef WITH_SHADER_RENDERER
+	if (use_shaders)
+		draw_vehicle_shaded( cam, drawing_to_screen );
+	else
+#endif
+	draw_vehicle( cam, drawing_to_screen );
 
 	/* Draw all active auxiliary objects */
 	auxiliary_objects( AUXOBJS_DRAW, cam_id );
@@ -279,18 +783,28 @@ ogl_draw( int cam_id )
 	}
 #endif /* 0 */
 
-	/* Initialize string drawer (i.e. inform of viewport dimensions) */
-	ogl_draw_string( cam, RESET, NIL );
+	if (!headless) {
+		/* Initialize string drawer (i.e. inform of viewport dimensions) */
+		ogl_draw_string( cam, RESET, NIL );
 
-	/* Finally, draw info display (nothing if it's turned off)
-	 * Only the primary camera or an off-screen image gets this */
-	if ((cam_id == 0) || !drawing_to_screen)
-		info_display( INFODISP_DRAW, NIL );
+		/* Finally, draw info display (nothing if it's turned off)
+		 * Only the primary camera or an off-screen image gets this */
+		if ((cam_id == 0) || !drawing_to_screen)
+			info_display( INFODISP_DRAW, NIL );
+	}
 
 	if (drawing_to_screen) {
-		gtk_gl_area_swap_buffers( GTK_GL_AREA(cam->ogl_w) );
+		/* Get the next frame's warp going while the GL is busy
+		 * with this one */
+		warping_ahead = warp( WARP_DISTORT_AHEAD, cam );
+		/* (ogl_draw_split( ) swaps once all panes are drawn) */
+		if (!split_pass)
+			gtk_gl_area_swap_buffers( GTK_GL_AREA(cam->ogl_w) );
 		profile( PROFILE_OGLDRAW_DONE );
 		cam->redraw = FALSE;
+		/* Come back for the result */
+		if (warping_ahead)
+			queue_redraw( cam_id );
 	}
 
 #ifdef SUPER_DEBUG
@@ -300,6 +814,182 @@ ogl_draw( int cam_id )
 }
 
 
+/* Draws a width x height tile of the off-screen image (out_cam), with its
+ * lower left corner at (x, y) in the image, for images bigger than the GL
+ * can draw in one go. The caller sets the viewport to the tile. As the
+ * vehicle looks the same in every tile of an image, it is warped only if
+ * warp_it is TRUE (i.e. for the first tile) */
+void
+ogl_draw_tile( int x, int y, int width, int height, int warp_it )
+{
+	tile_x = x;
+	tile_y = y;
+	tile_width = width;
+	tile_height = height;
+	tile_warp = warp_it;
+	ogl_draw( -1 );
+	tile_width = 0;
+	tile_height = 0;
+	tile_warp = TRUE;
+}
+
+
+/* Works out the pane of the primary viewport (in GL window coordinates)
+ * that a camera gets in split view: they go in a grid, left to right and
+ * top to bottom, that is as close to square as can be */
+static void
+split_pane( int cam_id, int *x, int *y, int *width, int *height )
+{
+	GtkWidget *ogl_w;
+	int w, h;
+	int cols, rows;
+	int col, row;
+
+	ogl_w = usr_cams[0]->ogl_w;
+	w = ogl_w->allocation.width;
+	h = ogl_w->allocation.height;
+	cols = (int)ceil( sqrt( (double)num_cams ) );
+	rows = (num_cams + cols - 1) / cols;
+	col = cam_id % cols;
+	row = cam_id / cols;
+
+	*x = col * w / cols;
+	*width = (col + 1) * w / cols - *x;
+	/* (rows go top to bottom, GL y bottom to top) */
+	*y = h - (row + 1) * h / rows;
+	*height = h - row * h / rows - *y;
+}
+
+
+/* Fits each camera's width/height (which its frustum and culling go by)
+ * to its pane in split view, or else to its own viewport */
+void
+ogl_split_layout( void )
+{
+	camera *cam;
+	int x, y;
+	int i;
+
+	for (i = 0; i < num_cams; i++) {
+		cam = usr_cams[i];
+		if (split_view)
+			split_pane( i, &x, &y, &cam->width, &cam->height );
+		else {
+			cam->width = cam->ogl_w->allocation.width;
+			cam->height = cam->ogl_w->allocation.height;
+		}
+	}
+}
+
+
+/* Returns the ID of the camera whose split view pane is at (x, y) in the
+ * primary viewport (in widget coordinates, i.e. y going down) */
+int
+ogl_split_pane_at( int x, int y )
+{
+	int px, py, width, height;
+	int i;
+
+	y = usr_cams[0]->ogl_w->allocation.height - 1 - y;
+	for (i = 0; i < num_cams; i++) {
+		split_pane( i, &px, &py, &width, &height );
+		if ((x >= px) && (x < (px + width)) && (y >= py) && (y < (py + height)))
+			return i;
+	}
+
+	return 0;
+}
+
+
+/* Redraws all the cameras in split view, each into its pane of the primary
+ * viewport. That makes for one context to make current and one buffer
+ * swap, however many cameras there are, with the vertex buffers of shared
+ * views uploaded just once (see upload_view( )) */
+void
+ogl_draw_split( void )
+{
+	GtkWidget *ogl_w;
+	int x, y, width, height;
+	int i;
+
+	ogl_w = usr_cams[0]->ogl_w;
+	gtk_gl_area_make_current( GTK_GL_AREA(ogl_w) );
+
+	/* Blank out whatever the panes leave uncovered */
+	glViewport( 0, 0, ogl_w->allocation.width, ogl_w->allocation.height );
+	set_clear_color( );
+	glClear( GL_COLOR_BUFFER_BIT );
+
+	/* (clearing is confined to a pane by the scissor box) */
+	glEnable( GL_SCISSOR_TEST );
+	split_pass = TRUE;
+	for (i = 0; i < num_cams; i++) {
+		split_pane( i, &x, &y, &width, &height );
+		glViewport( x, y, width, height );
+		glScissor( x, y, width, height );
+		ogl_draw( i );
+	}
+	split_pass = FALSE;
+	glDisable( GL_SCISSOR_TEST );
+
+	gtk_gl_area_swap_buffers( GTK_GL_AREA(ogl_w) );
+}
+
+
+/* Deletes the GL buffer objects of a camera (before its viewport goes).
+ * They belong to all the viewports' contexts, and the primary one is
+ * around for sure (the camera's own may never have been realized, if it
+ * was spawned in split view) */
+void
+ogl_release_buffers( camera *cam )
+{
+#ifdef WITH_BUFFER_OBJECTS
+	if (cam->vbuf == 0)
+		return;
+	gtk_gl_area_make_current( GTK_GL_AREA(usr_cams[0]->ogl_w) );
+	glDeleteBuffers( 1, &cam->vbuf );
+	cam->vbuf = 0;
+	cam->vbuf_serial = 0;
+#endif
+}
+
+
+/* Returns TRUE if the GL takes buffer objects (see ogl_initialize( )) */
+int
+ogl_buffer_objects( void )
+{
+#ifdef WITH_BUFFER_OBJECTS
+	return use_buffer_objects;
+#else
+	return FALSE;
+#endif
+}
+
+
+/* Prints how much vertex data the viewports have been handing to the GL
+ * (for PERFSTATS) */
+void
+ogl_show_upload_stats( void )
+{
+	const char *path = "client arrays";
+	double kb;
+
+#ifdef WITH_BUFFER_OBJECTS
+	if (use_buffer_objects)
+		path = "buffer objects";
+#endif
+#ifdef WITH_SHADER_RENDERER
+	if (use_shaders)
+		path = "packed buffer objects (shaders)";
+#endif
+	kb = bytes_uploaded / 1024.0 / (double)MAX(1, num_views_drawn);
+	printf( "Vertex upload: %.1f KB/frame via %s", kb, path );
+	if (num_views_uploaded > 0)
+		printf( " (%d of %d frames uploaded)", num_views_uploaded, num_views_drawn );
+	printf( "\n" );
+}
+
+
 /* Draws a string in the viewport
  * Meaning of args can vary, see initial switch statement
  * "size" specifies size of text: 0 (small), 1 (medium) or 2 (large)
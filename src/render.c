@@ -0,0 +1,337 @@
+/* render.c */
+
+/* Headless (display-less) rendering */
+
+/*
+ *  ``The contents of this file are subject to the Mozilla Public License
+ *  Version 1.0 (the "License"); you may not use this file except in
+ *  compliance with the License. You may obtain a copy of the License at
+ *  http://www.mozilla.org/MPL/
+ *
+ *  Software distributed under the License is distributed on an "AS IS"
+ *  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+ *  License for the specific language governing rights and limitations
+ *  under the License.
+ *
+ *  The Original Code is the "Light Speed!" relativistic simulator.
+ *
+ *  The Initial Developer of the Original Code is Daniel Richard G.
+ *  Portions created by the Initial Developer are Copyright (C) 1999
+ *  Daniel Richard G. <skunk@mit.edu> All Rights Reserved.
+ *
+ *  Contributor(s): ______________________________________.''
+ */
+
+
+#include "lightspeed.h"
+
+#ifdef WITH_HEADLESS_RENDERER
+
+#ifdef HAVE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+#ifdef HAVE_OSMESA
+#include <GL/osmesa.h>
+#endif
+
+
+#ifdef HAVE_EGL
+/* EGL display and context, and the frame buffer object drawn into (as
+ * there is no window, the context has no frame buffer of its own) */
+static EGLDisplay egl_dpy = EGL_NO_DISPLAY;
+static EGLContext egl_ctx = EGL_NO_CONTEXT;
+static unsigned int fbo = 0;
+static unsigned int fbo_bufs[2];
+#endif
+#ifdef HAVE_OSMESA
+/* OSMesa context, and the memory it draws into */
+static OSMesaContext osmesa_ctx = NULL;
+static unsigned char *osmesa_buf = NULL;
+#endif
+/* Size of what the context draws into: the whole image, or (for images
+ * too big for the GL) a tile of it */
+static int surface_width, surface_height;
+
+
+#ifdef HAVE_EGL
+/* Makes an EGL context current without a display (on Mesa's surfaceless
+ * platform where available), drawing into a width x height FBO, or one as
+ * big as the GL allows if tiled. Returns FALSE if there is none to be had */
+static int
+create_egl_context( int width, int height, int tiled )
+{
+	PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display;
+	EGLConfig config = NULL;
+	EGLint num_configs = 0;
+	EGLint major, minor;
+	const EGLint config_attribs[] = {
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	int max_size = 0;
+
+	get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress( "eglGetPlatformDisplayEXT" );
+	if (get_platform_display != NULL)
+		egl_dpy = get_platform_display( EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL );
+	if (egl_dpy == EGL_NO_DISPLAY)
+		egl_dpy = eglGetDisplay( EGL_DEFAULT_DISPLAY );
+	if (egl_dpy == EGL_NO_DISPLAY)
+		return FALSE;
+	if (!eglInitialize( egl_dpy, &major, &minor ))
+		return FALSE;
+	if (!eglBindAPI( EGL_OPENGL_API ))
+		return FALSE;
+
+	/* (surfaceless displays may offer no configs, which is fine
+	 * with EGL_KHR_no_config_context) */
+	eglChooseConfig( egl_dpy, config_attribs, &config, 1, &num_configs );
+	if (num_configs == 0)
+		config = (EGLConfig)0; /* EGL_NO_CONFIG_KHR */
+	egl_ctx = eglCreateContext( egl_dpy, config, EGL_NO_CONTEXT, NULL );
+	if (egl_ctx == EGL_NO_CONTEXT)
+		return FALSE;
+	if (!eglMakeCurrent( egl_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, egl_ctx ))
+		return FALSE;
+
+#ifdef GL_VERSION_3_0
+	glGetIntegerv( GL_MAX_RENDERBUFFER_SIZE, &max_size );
+	if (tiled) {
+		width = MIN(width, max_size);
+		height = MIN(height, max_size);
+	}
+	if ((width > max_size) || (height > max_size)) {
+		fprintf( stderr, "ERROR: Image size exceeds the GL's limit of %dx%d\n", max_size, max_size );
+		return FALSE;
+	}
+	glGenRenderbuffers( 2, fbo_bufs );
+	glBindRenderbuffer( GL_RENDERBUFFER, fbo_bufs[0] );
+	glRenderbufferStorage( GL_RENDERBUFFER, GL_RGBA8, width, height );
+	glBindRenderbuffer( GL_RENDERBUFFER, fbo_bufs[1] );
+	glRenderbufferStorage( GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height );
+	glGenFramebuffers( 1, &fbo );
+	glBindFramebuffer( GL_FRAMEBUFFER, fbo );
+	glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, fbo_bufs[0] );
+	glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, fbo_bufs[1] );
+	surface_width = width;
+	surface_height = height;
+
+	return glCheckFramebufferStatus( GL_FRAMEBUFFER ) == GL_FRAMEBUFFER_COMPLETE;
+#else
+	/* No FBOs, so nothing to draw into */
+	return (max_size > 0);
+#endif /* not GL_VERSION_3_0 */
+}
+#endif /* HAVE_EGL */
+
+
+#ifdef HAVE_OSMESA
+/* Makes an OSMesa context current, drawing into a width x height buffer
+ * in memory. Returns FALSE if that doesn't work out */
+static int
+create_osmesa_context( int width, int height )
+{
+	osmesa_ctx = OSMesaCreateContextExt( OSMESA_RGBA, 24, 0, 0, NULL );
+	if (osmesa_ctx == NULL)
+		return FALSE;
+	osmesa_buf = xmalloc( width * height * 4 );
+	surface_width = width;
+	surface_height = height;
+
+	return OSMesaMakeCurrent( osmesa_ctx, osmesa_buf, GL_UNSIGNED_BYTE, width, height );
+}
+#endif /* HAVE_OSMESA */
+
+
+/* Gets a software GL context going, of whichever kind is available, for
+ * drawing a width x height image, or if tiled, a tile of it at a time */
+static int
+create_context( int width, int height, int tiled )
+{
+	if (tiled) {
+		width = MIN(width, RENDER_TILE_SIZE);
+		height = MIN(height, RENDER_TILE_SIZE);
+	}
+#ifdef HAVE_EGL
+	if (create_egl_context( width, height, tiled ))
+		return TRUE;
+#endif
+#ifdef HAVE_OSMESA
+	if (create_osmesa_context( width, height ))
+		return TRUE;
+#endif
+
+	return FALSE;
+}
+
+
+static void
+destroy_context( void )
+{
+#ifdef HAVE_EGL
+	if (egl_dpy != EGL_NO_DISPLAY) {
+#ifdef GL_VERSION_3_0
+		if (fbo != 0) {
+			glDeleteFramebuffers( 1, &fbo );
+			glDeleteRenderbuffers( 2, fbo_bufs );
+			fbo = 0;
+		}
+#endif
+		eglMakeCurrent( egl_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT );
+		if (egl_ctx != EGL_NO_CONTEXT)
+			eglDestroyContext( egl_dpy, egl_ctx );
+		eglTerminate( egl_dpy );
+		egl_ctx = EGL_NO_CONTEXT;
+		egl_dpy = EGL_NO_DISPLAY;
+	}
+#endif
+#ifdef HAVE_OSMESA
+	if (osmesa_ctx != NULL) {
+		OSMesaDestroyContext( osmesa_ctx );
+		xfree( osmesa_buf );
+		osmesa_ctx = NULL;
+	}
+#endif
+}
+
+
+/* Draws the image (out_cam) and writes it out. Images bigger than the GL
+ * surface are drawn in tiles, a band of them across the image at a time,
+ * whose rows are then written out (the GL's rows go bottom to top). Each
+ * tile is drawn with a margin around it, so that wide lines crossing its
+ * edges come out whole. Returns FALSE on a write error */
+static int
+draw_image( const char *filename, int width, int height )
+{
+	image_file *img;
+	unsigned char *band;
+	int stride, margin;
+	int x0, y0, y1;
+	int tw, th;
+	int ok = TRUE;
+
+	img = image_open( filename, width, height );
+	if (img == NULL)
+		return FALSE;
+
+	if ((width > surface_width) || (height > surface_height))
+		margin = RENDER_TILE_MARGIN;
+	else
+		margin = 0;
+	stride = 3 * width;
+	band = xmalloc( MIN(surface_height - 2 * margin, height) * stride );
+	/* (tiles are read into place in the band) */
+	glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+	glPixelStorei( GL_PACK_ROW_LENGTH, width );
+	for (y1 = height; ok && (y1 > 0); y1 -= th) {
+		th = MIN(surface_height - 2 * margin, y1);
+		y0 = y1 - th;
+		for (x0 = 0; x0 < width; x0 += tw) {
+			tw = MIN(surface_width - 2 * margin, width - x0);
+			glViewport( 0, 0, tw + 2 * margin, th + 2 * margin );
+			/* (the vehicle gets warped for the first tile only) */
+			ogl_draw_tile( x0 - margin, y0 - margin, tw + 2 * margin, th + 2 * margin, (x0 == 0) && (y1 == height) );
+			glReadPixels( margin, margin, tw, th, GL_RGB, GL_UNSIGNED_BYTE, band + 3 * x0 );
+		}
+		ok = image_write_rows( img, band + (th - 1) * stride, - stride, th );
+	}
+	glPixelStorei( GL_PACK_ROW_LENGTH, 0 );
+	xfree( band );
+
+	if (!image_close( img ))
+		ok = FALSE;
+	if (!ok)
+		fprintf( stderr, "ERROR: Cannot write image file: %s\n", filename );
+
+	return ok;
+}
+
+
+/* Sets up the scene for drawing without a display: the given object (or
+ * the default lattice, if NULL) at the current velocity, as seen by the
+ * default camera, or one at view[ ] = { phi, theta, distance } (as in the
+ * Camera Position dialog) if that is not NULL. Leaves a software GL context
+ * current, for drawing a width x height image (a tile at a time, if
+ * tiled), and returns the camera (NULL on failure) */
+camera *
+render_begin( const char *obj_file, int width, int height, const float *view, int tiled )
+{
+	camera *cam;
+
+	headless = TRUE;
+
+	/* Generate/load object */
+	if (obj_file == NULL)
+		make_lattice( DEF_LATTICE_X, DEF_LATTICE_Y, DEF_LATTICE_Z, DEF_LATTICE_SMOOTH );
+	else if (import_objects( obj_file ) < 0)
+		return NULL;
+
+	/* Set up the camera */
+	cam = new_camera( );
+	if (view != NULL) {
+		/* (user phi/theta to struct camera phi/theta, as in
+		 * camera_reset( )) */
+		cam->phi = fmod( view[0] + 180.0, 360.0 );
+		cam->theta = - view[1];
+		cam->distance = view[2];
+		camera_calc_xyz( CAM_POSITION, cam );
+	}
+	cam->width = width;
+	cam->height = height;
+
+	warp( INITIALIZE, NULL );
+	if (DEF_DGAMMA_CORRECT != 1.0) {
+		calc_dgamma_lut( DEF_DGAMMA_CORRECT );
+		dgamma_correct = TRUE;
+	}
+	else
+		dgamma_correct = FALSE;
+
+	if (!create_context( width, height, tiled )) {
+		fprintf( stderr, "ERROR: Cannot create an off-screen GL context\n" );
+		destroy_context( );
+		return NULL;
+	}
+	ogl_initialize( NULL, NULL );
+	glViewport( 0, 0, surface_width, surface_height );
+
+	return cam;
+}
+
+
+/* Done drawing, lets go of the GL context */
+void
+render_end( void )
+{
+	destroy_context( );
+}
+
+
+/* Renders the scene (see render_begin( )) into an image file without a
+ * display. Returns the program's exit status */
+int
+render_headless( const char *obj_file, const char *image_file, int width, int height, const float *view )
+{
+	camera *cam;
+	int ok;
+
+	if (image_format( image_file ) < 0) {
+		fprintf( stderr, "ERROR: Cannot write images of this type: %s\n", image_file );
+		return -1;
+	}
+
+	cam = render_begin( obj_file, width, height, view, TRUE );
+	if (cam == NULL)
+		return -1;
+
+	/* Draw it as a snapshot */
+	memcpy( &out_cam, cam, sizeof(camera) );
+	ok = draw_image( image_file, width, height );
+	render_end( );
+
+	return ok ? 0 : -1;
+}
+
+#endif /* WITH_HEADLESS_RENDERER */
+
+/* end render.c */
@@ -35,6 +35,33 @@
  * 2022, there is no point in having the SRS exporter...*/
 // #define WITH_SRS_EXPORTER
 
+/* Vectorized (AVX2) warp( ) kernel, picked at run time if the CPU supports it.
+ * The scalar kernel is always compiled in, and is used as the fallback */
+#define WITH_SIMD_WARP
+
+/* Spreads the warp( ) engine's work across multiple threads (needs
+ * POSIX threads). The thread count can be set with the THREADS= command */
+#define WITH_THREADED_WARP
+
+/* Hands warped vertices to the GL in buffer objects (OpenGL 1.5), uploaded
+ * only when they change, with the indices kept on the GL side. Auxiliary
+ * objects keep their geometry in them too. Contexts without them (and
+ * off-screen rendering of the vehicle) use client-side arrays */
+#define WITH_BUFFER_OBJECTS
+
+/* Draws the vehicle with GLSL shaders (OpenGL 3.3), which do the lighting
+ * and display gamma, from vertices packed to half the size. One draw call
+ * per object covers all of its visible meshlets. Other GLs get the
+ * fixed-function pipeline. Needs WITH_BUFFER_OBJECTS */
+#define WITH_SHADER_RENDERER
+
+/* Allows rendering straight to an image file without any display (see
+ * --render), on a software GL context from EGL (surfaceless) or OSMesa.
+ * Needs one of those, and libpng or libtiff. --render makes no GTK+
+ * calls, but it is the same binary, so the GTK+ libraries must still be
+ * installed for it to start */
+#define WITH_HEADLESS_RENDERER
+
 
 /**** Completely arbitrary defaults **************************************/
 
@@ -55,6 +82,13 @@
 #define DEF_CAMERA_THETA	-10.0
 #define DEF_CAMERA_FOV		60.0
 
+/* Default image size for --render */
+#define DEF_RENDER_WIDTH	1024
+#define DEF_RENDER_HEIGHT	768
+
+/* Frame rate of animations exported with --animate */
+#define DEF_EXPORT_FPS		30.0
+
 /* Initial info display configuration */
 #define DEF_INFODISP_ACTIVE		TRUE
 #define DEF_INFODISP_SHOW_VELOCITY	TRUE
@@ -82,6 +116,72 @@
 #define USE_LOOKUP_TABLES	TRUE
 /* Table resolution (each will have LUT_RES+1 entries) */
 #define LUT_RES			1023
+/* Doppler shift tables cover frequency ratios within this many octaves
+ * of 1 (beyond that, up to the 15 or so MAX_VELOCITY can come to, the
+ * shift is calculated outright) */
+#define DOPPLER_LUT_OCTAVES	8
+/* Polynomials (and reciprocal square roots) in place of the tables for
+ * normal renormalization, normal interpolation and display gamma in the
+ * warp( ) kernels, which keeps them free of gathers. These are more precise
+ * too; the warp benchmark prints the errors of both */
+#define WARP_POLY_APPROX	TRUE
+
+/* Warp engine threads (0 == one per CPU) and the most it will accept */
+#define DEF_WARP_THREADS	0
+#define MAX_WARP_THREADS	64
+/* Number of vertices handed to a warp thread at a time. Should be a
+ * multiple of WARP_SIMD_WIDTH, and small enough for the input and output
+ * of a chunk to stay in cache */
+#define WARP_CHUNK_SIZE		1024
+/* Most cameras a warp kernel handles in one pass over the vertices (see
+ * WARP_DISTORT_CAMERAS) */
+#define WARP_MAX_CAMERA_BATCH	8
+
+/* Effects whose effective velocity (as a fraction of c) is below this are
+ * skipped by the warp( ) engine, as they would make no visible difference.
+ * With all of them below it, vertices are merely copied */
+#define WARP_NEGLIGIBLE_BETA	1E-6
+
+/* Images from --render bigger than this (in either direction, or bigger
+ * than the GL allows) are drawn in tiles of at most this size, overlapping
+ * by twice the margin (in pixels). A band of tiles across the image is
+ * held in memory at a time */
+#define RENDER_TILE_SIZE	2048
+#define RENDER_TILE_MARGIN	4
+
+/* Animation export: frames being read back from the GL (in pixel buffer
+ * objects) while the next ones are drawn, and threads encoding them
+ * (0 == one per CPU). Up to two frames per thread wait to be encoded */
+#define EXPORT_FRAMES_IN_FLIGHT	3
+#define DEF_EXPORT_THREADS	0
+
+/* Warp pipeline depth. With 2, each camera's view for the next frame is
+ * warped in the background while the current one is being drawn (at the
+ * cost of one frame of lag), 1 warps synchronously. See PIPELINE= */
+#define DEF_WARP_PIPELINE_DEPTH	2
+
+/* Frustum culling: objects are split into meshlets of this many triangles,
+ * and only those in a camera's view get warped and drawn. Warping goes by
+ * blocks of WARP_CULL_BLOCK vertices (a multiple of WARP_SIMD_WIDTH that
+ * divides WARP_CHUNK_SIZE). Camera field of view is widened by
+ * WARP_CULL_MARGIN (in radians) for the test, to cover extrapolation */
+#define MESHLET_TRIANGLES	128
+#define WARP_CULL_BLOCK		64
+#define WARP_CULL_MARGIN	0.01
+
+/* Slack in camera/vehicle position (as a fraction of vehicle size) within
+ * which a previously warped view is reused */
+#define WARP_KEY_TOLERANCE	1E-5
+
+/* While a camera is being dragged about (see WARP_INTERACTIVE), views are
+ * extrapolated from the last exact warp until the estimated error exceeds
+ * these: for vertex positions, in radians of view angle; for colors, as a
+ * fraction of the frequency shift */
+#define WARP_EXTRAPOLATION_TOLERANCE	2E-3
+#define WARP_EXTRAPOLATION_COLOR_TOLERANCE	0.02
+
+/* Post-transform vertex cache size that imported objects are optimized for */
+#define VERTEX_CACHE_SIZE	32
 
 /* Lattice geometry (in meters) */
 #define LATTICE_UNIT_SIZE	1.0
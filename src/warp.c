@@ -26,7 +26,131 @@
 #include "lightspeed.h"
 
 
+/* Look-up tables */
+#if USE_LOOKUP_TABLES
+static float sqrt01_lut[LUT_RES + 1];
+/* Doppler shift tables, indexed as per doppler_lut_pos( ). The shifted
+ * color is a linear function of the original, so for incoming (white)
+ * light a table entry holds the resulting RGB, and for reflected light
+ * the 3x3 matrix (row-major) that maps original RGB to shifted RGB */
+static float doppler_in_lut[LUT_RES + 1][3];
+static float doppler_ref_lut[LUT_RES + 1][9];
+#endif
+/* (the SIMD kernel uses these two even without USE_LOOKUP_TABLES) */
+static float normal_interp_lut1[LUT_RES + 1];
+static float normal_interp_lut2[LUT_RES + 1];
+static int tables_ready = FALSE;
+
+/* TRUE if the AVX2 kernel is in use */
+static int use_simd = FALSE;
+
+/* Settings of the warps done for the user interface */
+static warp_context ui_ctx;
+
+/* Number of camera views warped, redrawn as-is, and taken over from
+ * another camera at the same position */
+static int num_views_warped = 0;
+static int num_views_cached = 0;
+static int num_views_shared = 0;
+static int num_camera_batches = 0;
+
+/* Contracted geometry cache stats (see update_contraction_cache( )) */
+static int num_lc_builds = 0;
+static int num_lc_reuses = 0;
+static double lc_build_t = 0.0;
+
+/* TRUE while a camera is being dragged about (see WARP_INTERACTIVE) */
+static int interactive = FALSE;
+/* Views brought up to date by extrapolation, and exact warps done as it
+ * would have gone too far */
+static int num_views_extrapolated = 0;
+static int num_extrapolation_limits = 0;
+
+/* What the worker threads get handed: num_wps sets of constants, each of
+ * which warps all of the objects into its own num_objs arrays in out[ ]
+ * (NULL == in place, with a single set only) */
+typedef struct {
+	const warp_params *wp;
+	int num_wps;
+	ogl_object **objs;
+	int num_objs;
+	ogl_point **out;
+	int use_lc_cache;	/* Use the objects' contracted geometry */
+	point **grads;		/* Where the gradients go (cf. warped_view),
+				 * laid out as out[ ], or NULL for none */
+	unsigned char **blocks;	/* Per object, the vertex blocks to warp
+				 * (cf. warped_view), or NULL for all */
+} warp_job;
+
+/* Camera and vehicle movement to extrapolate a view by */
+typedef struct {
+	warped_view *view;
+	float d_cam_x, d_cam_y, d_cam_z;
+	float d_real_x;
+} extrapolate_job;
+
+/* Warp pipeline: depth (1 or 2), the camera whose next view is being
+ * warped in the background (if any), and the job doing it */
+static int pipeline_depth = DEF_WARP_PIPELINE_DEPTH;
+static camera *ahead_cam = NULL;
+static warp_job ahead_job;
+/* Number of views warped ahead, views shown out of date (until the one
+ * warped ahead comes in), and time spent waiting for the background job */
+static int num_views_ahead = 0;
+static int num_views_stale = 0;
+static double ahead_wait_t = 0.0;
+/* Last serial number given to a warped view's contents (see ogl_draw( )) */
+static unsigned int last_view_serial = 0;
+
+/* Frustum culling: vertex blocks warped out of those in the warped views,
+ * blocks warped late (for a camera that turned to them), and meshlets
+ * drawn out of those in the views drawn */
+static double num_blocks_warped = 0.0;
+static double num_blocks_total = 0.0;
+static double num_blocks_late = 0.0;
+static double num_meshlets_drawn = 0.0;
+static double num_meshlets_total = 0.0;
+
+
 /* Forward declarations */
+static void init_tables( void );
+static void calc_warp_params( const warp_context *ctx, point *cam_pos, warp_params *wp );
+static void run_warp( const warp_params *wp, int num_wps, ogl_object **objs, int num_objs, ogl_point **out_buffers, point **grads, unsigned char **blocks, int use_lc_cache );
+static void update_contraction_cache( const warp_params *wp );
+static void contract_range( int obj_id, int v0, int v1, void *data );
+static int warp_keys_match( const warp_params *key1, const warp_params *key2 );
+static int warp_frames_match( const warp_params *wp1, const warp_params *wp2 );
+static int distort_cameras( const warp_params *wp );
+static warped_view *alloc_warped_view( void );
+static point **prepare_warped_view( warped_view *view, const warp_params *wp );
+static float vehicle_distance( const point *pos, const warp_params *wp );
+static int extrapolate_view( camera *cam, const warp_params *wp );
+static void extrapolate_range( int obj_id, int v0, int v1, void *data );
+static void warp_gradients( ogl_object *obj, point *grads, int v0, int v1, const warp_params *wp );
+static void unref_warped_view( warped_view *view );
+static void release_warped_view( camera *cam );
+static void discard_warped_views( camera *cam );
+static void flip_warped_views( camera *cam );
+static void finish_ahead( void );
+static void warp_range( int obj_id, int v0, int v1, void *data );
+static void warp_blocks( const warp_job *job, int obj_id, int v0, int v1 );
+static unsigned char **alloc_masks( int per_meshlet );
+static void free_masks( unsigned char **masks );
+static void cull_meshlets( camera *cam, const warp_params *wp, unsigned char **need );
+static int cover_view( camera *cam );
+static void warp_kernel_scalar( ogl_object *obj, ogl_point *out, int v0, int v1, const warp_params *wp );
+static void warp_kernel_scalar_multi( ogl_object *obj, const point *vertices, const point *normals, ogl_point **outs, int v0, int v1, const warp_params *wps, int num_wps, int effects );
+static void warp_benchmark( const warp_params *wp );
+static void batch_benchmark( const warp_context *ctx, point *cam_pos );
+static void deform_precision_check( void );
+static void poly_precision_check( void );
+#if USE_LOOKUP_TABLES
+static void init_doppler_luts( void );
+static int doppler_lut_pos( float freq_ratio, float *frac );
+static void doppler_shift_lut( rgb_color *color, float freq_ratio );
+static void doppler_shift_ref_lut( rgb_color *color, float freq_ratio );
+static void doppler_benchmark( void );
+#endif
 static void doppler_shift( rgb_color *color, float freq_ratio );
 static void doppler_shift_ref( rgb_color *color, float freq_ratio );
 
@@ -39,382 +163,2124 @@ warp( int message, void *data )
 	static int do_optical_deformation = TRUE;
 	static int do_headlight_effect = TRUE;
 	static int do_doppler_shift = TRUE;
-	static float percent_contraction = 1.0;
-	static float percent_deformation = 1.0;
-	static float percent_dopplershift = 1.0;
-	static float percent_headlight = 1.0;
-#if USE_LOOKUP_TABLES
-	static float sqrt01_lut[LUT_RES + 1];
-	static float normal_interp_lut1[LUT_RES + 1];
-	static float normal_interp_lut2[LUT_RES + 1];
-#endif
 	ogl_object *obj;
-	ogl_point *pnt;
+	ogl_point **out = NULL;
+	point **grads = NULL;
+	unsigned char **blocks = NULL;
+	camera *cam = NULL;
+	warped_view *view;
 	point *cam_pos;
-	point vertex;
-	point normal;
-	rgb_color color;
-	rgb_color in_ray;
-	double LC_gamma;
-	double OD_v, OD_v2, OD_v2_min_C2;
-	double DS_v_over_C, DS_gamma;
-	double HE_v_over_C, HE_gamma;
-	double d_vertex_x;
-	double dx,dy,dz;
-	double dyz2, dist2;
-	double t;
-	float cos_alpha_n, cos_alpha_c;
-	float freq_ratio;
-	float inten_ratio;
-	float intensity;
-	float len2, len;
-	float k;
+	warp_params wp;
 	int message2 = 0;
-	int o, vn, i;
+	int o, i;
+
+	switch (message) {
+	case WARP_DISTORT:
+	case WARP_DISTORT_CAMERA:
+	case WARP_DISTORT_CAMERAS:
+	case WARP_DISTORT_AHEAD:
+	case WARP_CULL:
+	case WARP_BENCHMARK:
+	case INITIALIZE:
+	case RESET:
+		break;
 
-	if ((message != WARP_DISTORT) && (message != INITIALIZE))
+	default:
 		message2 = *((int *)data); /* several methods use this value */
+		break;
+	}
 
 	switch (message) {
 	case WARP_DISTORT:
+		/* Warp in place, i.e. into the objects' own iarrays */
 		cam_pos = (point *)data;
 		break;
 
-	case WARP_LORENTZ_CONTRACTION:
-		do_lorentz_contraction = message2;
-		if (do_lorentz_contraction)
-			transition( &percent_contraction, FALSE, TRANS_SIGMOID, 4.0, 1.0, -1 );
-		else
-			transition( &percent_contraction, FALSE, TRANS_SIGMOID, 4.0, 0.0, -1 );
-		return 0;
+	case WARP_DISTORT_CAMERA:
+		/* Bring the camera's warped view up to date, if need be
+		 * (the return value says whether any warping was done) */
+		cam = (camera *)data;
+		cam_pos = &cam->pos;
+		/* Bring in the view warped ahead for it, if any */
+		if (cam == ahead_cam)
+			finish_ahead( );
+		if (cam->next_ready)
+			flip_warped_views( cam );
+		break;
+
+	case WARP_DISTORT_CAMERAS:
+		/* Bring the warped views of all cameras due for a redraw
+		 * up to date, warping those that need it together in one
+		 * pass. Returns the number of views warped */
+		if (num_cams == 0)
+			return 0;
+		cam_pos = &usr_cams[0]->pos;
+		break;
+
+	case WARP_DISTORT_AHEAD:
+		/* Start warping the camera's view for the next frame, as
+		 * things stand now, in the background. Returns TRUE if
+		 * anything needed doing (the camera should then be redrawn,
+		 * which picks up the result) */
+		if (pipeline_depth < 2)
+			return FALSE;
+		cam = (camera *)data;
+		cam_pos = &cam->pos;
+		break;
+
+	case WARP_CULL:
+		/* Works out which meshlets of the camera's view are to be
+		 * drawn (into cam->visible), warping any parts of the view
+		 * that came into sight since it was warped. Returns TRUE if
+		 * any warping was done */
+		return cover_view( (camera *)data );
+
+	case WARP_PIPELINE_DEPTH:
+		pipeline_depth = CLAMP(message2, 1, 2);
+		return 0;
+
+	case WARP_INTERACTIVE:
+		/* A camera drag begins (TRUE) or ends (FALSE). In between,
+		 * views are extrapolated where they can be; at the end,
+		 * those that were get warped exactly on their next redraw */
+		interactive = message2;
+		if (interactive)
+			return 0;
+		for (i = 0; i < num_cams; i++) {
+			view = usr_cams[i]->view;
+			if ((view != NULL) && view->extrapolated)
+				memset( &view->key, 0, sizeof(warp_params) );
+		}
+		return 0;
+
+	case RESET:
+		/* Throw away the warped view of the given camera, or of
+		 * all cameras if none given. This needs to happen whenever
+		 * the vehicle geometry changes, and before it is freed */
+		finish_ahead( );
+		if (data != NULL)
+			discard_warped_views( (camera *)data );
+		else {
+			for (i = 0; i < num_cams; i++)
+				discard_warped_views( usr_cams[i] );
+			/* (contracted geometry too) */
+			for (o = 0; o < num_vehicle_objs; o++)
+				vehicle_objs[o]->lc_gamma = 0.0;
+		}
+		return 0;
+
+	case WARP_BENCHMARK:
+		/* Time the kernels against each other, as seen from
+		 * the primary camera */
+		cam_pos = &usr_cams[0]->pos;
+		break;
+
+	case WARP_LORENTZ_CONTRACTION:
+		do_lorentz_contraction = message2;
+		if (do_lorentz_contraction)
+			transition( &ui_ctx.percent_contraction, FALSE, TRANS_SIGMOID, 4.0, 1.0, -1 );
+		else
+			transition( &ui_ctx.percent_contraction, FALSE, TRANS_SIGMOID, 4.0, 0.0, -1 );
+		return 0;
+
+	case WARP_OPTICAL_DEFORMATION:
+		do_optical_deformation = message2;
+		if (do_optical_deformation)
+			transition( &ui_ctx.percent_deformation, FALSE, TRANS_SIGMOID, 4.0, 1.0, -1 );
+		else
+			transition( &ui_ctx.percent_deformation, FALSE, TRANS_SIGMOID, 4.0, 0.0, -1 );
+		return 0;
+
+	case WARP_HEADLIGHT_EFFECT:
+		do_headlight_effect = message2;
+		if (do_headlight_effect)
+			transition( &ui_ctx.percent_headlight, FALSE, TRANS_SIGMOID, 4.0, 1.0, -1 );
+		else
+			transition( &ui_ctx.percent_headlight, FALSE, TRANS_SIGMOID, 4.0, 0.0, -1 );
+		return 0;
+
+	case WARP_DOPPLER_SHIFT:
+		do_doppler_shift = message2;
+		if (do_doppler_shift)
+			transition( &ui_ctx.percent_dopplershift, FALSE, TRANS_SIGMOID, 4.0, 1.0, -1 );
+		else
+			transition( &ui_ctx.percent_dopplershift, FALSE, TRANS_SIGMOID, 4.0, 0.0, -1 );
+		return 0;
+
+	case QUERY:
+		switch (message2) {
+		case WARP_LORENTZ_CONTRACTION:
+			return do_lorentz_contraction;
+
+		case WARP_OPTICAL_DEFORMATION:
+			return do_optical_deformation;
+
+		case WARP_HEADLIGHT_EFFECT:
+			return do_headlight_effect;
+
+		case WARP_DOPPLER_SHIFT:
+			return do_doppler_shift;
+
+		case WARP_PIPELINE_DEPTH:
+			return pipeline_depth;
+
+		case WARP_INTERACTIVE:
+			return interactive;
+		}
+		return 0;
+
+	case INITIALIZE:
+		warp_context_init( &ui_ctx );
+		/* Start up worker threads */
+		warp_pool_init( DEF_WARP_THREADS );
+		return 0;
+
+	default:
+#ifdef DEBUG
+		crash( "warp( ): invalid message" );
+#endif
+		return 0;
+	}
+
+	/* Bring the interface's warp context up to date. Simulation
+	 * time (and x-location) depend on effective velocity used for
+	 * optical deformation */
+	ui_ctx.velocity = velocity;
+	warp_time( NIL, NIL, warp_deformation_velocity( &ui_ctx ), WARP_UPDATE_TIME_T );
+	ui_ctx.sim_time = cur_time_t;
+	/* (leaving display gamma to the GL, if it does that) */
+	ui_ctx.dgamma_correct = dgamma_correct && !shader_dgamma;
+	ui_ctx.dgamma_exp = dgamma_exp;
+	calc_warp_params( &ui_ctx, cam_pos, &wp );
+	vehicle_real_x = wp.real_x;
+
+#ifdef WARP_SIMD_X86
+	/* SIMD kernel reads the SoA streams, which warp_run( ) leaves
+	 * to whoever owns the objects */
+	if (use_simd) {
+		for (o = 0; o < num_vehicle_objs; o++) {
+			obj = vehicle_objs[o];
+			if (obj->soa0 == NULL)
+				update_ogl_object_soa( obj );
+		}
+	}
+#endif
+
+	if (message == WARP_BENCHMARK) {
+		finish_ahead( );
+		warp_benchmark( &wp );
+		batch_benchmark( &ui_ctx, cam_pos );
+		return use_simd;
+	}
+
+	if (message == WARP_DISTORT_CAMERAS)
+		return distort_cameras( &wp );
+
+	if (message == WARP_DISTORT_AHEAD) {
+		if ((cam->view != NULL) && warp_keys_match( &wp, &cam->view->key ))
+			return FALSE;
+		/* One at a time */
+		finish_ahead( );
+		if (cam->next_view == NULL)
+			cam->next_view = alloc_warped_view( );
+		/* (the view's key doubles as the job's copy of the constants) */
+		ahead_job.grads = prepare_warped_view( cam->next_view, &wp );
+		cam->next_ready = TRUE;
+		/* (just what the camera can see as it stands) */
+		cull_meshlets( cam, &wp, cam->next_view->blocks );
+		update_contraction_cache( &wp );
+		ahead_job.wp = &cam->next_view->key;
+		ahead_job.num_wps = 1;
+		ahead_job.objs = vehicle_objs;
+		ahead_job.num_objs = num_vehicle_objs;
+		ahead_job.out = cam->next_view->iarrays;
+		ahead_job.blocks = cam->next_view->blocks;
+		ahead_job.use_lc_cache = TRUE;
+		ahead_cam = cam;
+		warp_pool_run_async( vehicle_objs, num_vehicle_objs, warp_range, &ahead_job );
+		++num_views_ahead;
+		return TRUE;
+	}
+
+	if (cam != NULL) {
+		/* Nothing to do if the camera's view is still good */
+		if ((cam->view != NULL) && warp_keys_match( &wp, &cam->view->key )) {
+			++num_views_cached;
+			return FALSE;
+		}
+		/* Another camera at the same position may have
+		 * already done the work */
+		for (i = 0; i < num_cams; i++) {
+			view = usr_cams[i]->view;
+			if ((view == NULL) || (view == cam->view))
+				continue;
+			if (warp_keys_match( &wp, &view->key )) {
+				release_warped_view( cam );
+				cam->view = view;
+				++view->num_cams;
+				++num_views_shared;
+				return FALSE;
+			}
+		}
+		/* While dragging, extrapolating the view from its last
+		 * exact warp will mostly do */
+		if (extrapolate_view( cam, &wp ))
+			return TRUE;
+		/* With the pipeline on, an out-of-date view is shown as is,
+		 * and WARP_DISTORT_AHEAD has it caught up by the next frame
+		 * (auxiliary objects go where the vehicle was then, too) */
+		if ((pipeline_depth > 1) && (cam->view != NULL)) {
+			vehicle_real_x = cam->view->key.real_x;
+			++num_views_stale;
+			return FALSE;
+		}
+		/* Warp into a view of this camera's own */
+		if ((cam->view != NULL) && (cam->view->num_cams > 1))
+			release_warped_view( cam );
+		if (cam->view == NULL)
+			cam->view = alloc_warped_view( );
+		out = cam->view->iarrays;
+		grads = prepare_warped_view( cam->view, &wp );
+		++num_views_warped;
+		/* Only what is in sight (the rest, as need be, later) */
+		blocks = cam->view->blocks;
+		cull_meshlets( cam, &wp, blocks );
+	}
+
+	finish_ahead( );
+	update_contraction_cache( &wp );
+	run_warp( &wp, 1, vehicle_objs, num_vehicle_objs, out, grads, blocks, TRUE );
+	ui_ctx.wp = wp;
+
+	return TRUE;
+}
+
+
+/* Sets up a warp context with all effects at full strength, and the same
+ * display gamma correction as the user interface. The first call also
+ * builds the look-up tables, so it should not race with any other */
+void
+warp_context_init( warp_context *ctx )
+{
+	if (!tables_ready)
+		init_tables( );
+
+	ctx->percent_contraction = 1.0;
+	ctx->percent_deformation = 1.0;
+	ctx->percent_dopplershift = 1.0;
+	ctx->percent_headlight = 1.0;
+	ctx->velocity = MIN_VELOCITY;
+	ctx->sim_time = 0.0;
+	ctx->dgamma_correct = dgamma_correct && !shader_dgamma;
+	ctx->dgamma_lut = dgamma_lut;
+	ctx->dgamma_exp = dgamma_exp;
+	memset( &ctx->wp, 0, sizeof(warp_params) );
+}
+
+
+/* Warps the given objects as seen from cam_pos, with the settings in ctx,
+ * into out_buffers (one array per object, or NULL for the objects' own
+ * iarrays). This reads no global state, so any number of warps can run at
+ * once, as long as each has a context and output buffers of its own. SoA
+ * streams are not built here, objects without them get the scalar kernel */
+void
+warp_run( warp_context *ctx, ogl_object **objs, int num_objs, point *cam_pos, ogl_point **out_buffers )
+{
+	calc_warp_params( ctx, cam_pos, &ctx->wp );
+	run_warp( &ctx->wp, 1, objs, num_objs, out_buffers, NULL, NULL, FALSE );
+}
+
+
+/* Same as warp_run( ), but for a number of velocities (and simulation
+ * times, if sim_times is not NULL) at once, i.e. as many warps of the same
+ * objects with otherwise the same settings. out_buffers holds num_objs
+ * arrays per velocity, one velocity after another. The objects are gone
+ * through a cache-sized chunk at a time, with each chunk warped for all
+ * velocities before moving on, so the vertex data is only read in from
+ * memory once. ctx->wp is left with the constants of the last velocity */
+void
+warp_run_velocities( warp_context *ctx, ogl_object **objs, int num_objs, point *cam_pos, int num_velocities, const double *velocities, const double *sim_times, ogl_point **out_buffers )
+{
+	warp_context vctx;
+	warp_params *wps;
+	int i;
+
+	if (num_velocities < 1)
+		return;
+
+	wps = xmalloc( num_velocities * sizeof(warp_params) );
+	vctx = *ctx;
+	for (i = 0; i < num_velocities; i++) {
+		vctx.velocity = velocities[i];
+		if (sim_times != NULL)
+			vctx.sim_time = sim_times[i];
+		calc_warp_params( &vctx, cam_pos, &wps[i] );
+	}
+	run_warp( wps, num_velocities, objs, num_objs, out_buffers, NULL, NULL, FALSE );
+	ctx->wp = wps[num_velocities - 1];
+	xfree( wps );
+}
+
+
+/* Effective velocity used for optical deformation, which is also what
+ * simulation time (and hence the vehicle's x-location) goes by */
+double
+warp_deformation_velocity( const warp_context *ctx )
+{
+	return MAX(1.0, ctx->velocity * ctx->percent_deformation);
+}
+
+
+/* Builds the look-up tables, and picks a kernel */
+static void
+init_tables( void )
+{
+	int i;
+
+	for (i = 0; i <= LUT_RES; i++) {
+		/* Normal interpolation factor tables
+		 * Table 1 handles [0, 1] input range */
+		normal_interp_lut1[i] = DEG(atan( (double)i / LUT_RES )) / 90.0;
+		/* Table 2 handles (1, inf.) (via reciprocal) */
+		if (i > 0)
+			normal_interp_lut2[i] = DEG(atan( LUT_RES / (double)i )) / 90.0;
+#if USE_LOOKUP_TABLES
+		/* Square root table for [0, 1] range */
+		sqrt01_lut[i] = sqrt( (double)i / LUT_RES );
+#endif
+	}
+#if USE_LOOKUP_TABLES
+	init_doppler_luts( );
+#endif
+	normal_interp_lut2[0] = 1.0;
+#ifdef WARP_SIMD_X86
+	/* Pick the fastest kernel this CPU can run */
+	use_simd = warp_simd_supported( );
+#endif
+#ifdef DEBUG
+	printf( "Warp kernel: %s\n", use_simd ? "AVX2" : "scalar" );
+	fflush( stdout );
+#endif
+	tables_ready = TRUE;
+}
+
+
+/* Works out the per-frame warp constants for the given context and
+ * camera position */
+static void
+calc_warp_params( const warp_context *ctx, point *cam_pos, warp_params *wp )
+{
+	double v = ctx->velocity;
+
+	/* Effects too weak to be seen get left out altogether (with
+	 * their constants set to the identity, for the sake of the
+	 * kernels that do not specialize on them) */
+	wp->effects = 0;
+
+	/* Variables for Lorentz contraction */
+	if ((v * ctx->percent_contraction / C) > WARP_NEGLIGIBLE_BETA) {
+		wp->LC_gamma = lorentz_factor( v * ctx->percent_contraction );
+		wp->effects |= WARP_FX_CONTRACTION;
+	}
+	else
+		wp->LC_gamma = 1.0;
+
+	/* Variables for optical deformation */
+	wp->OD_v = warp_deformation_velocity( ctx );
+	wp->OD_v2 = SQR(wp->OD_v);
+	wp->OD_v2_min_C2 = wp->OD_v2 - C2;
+	wp->OD_v_over_C = wp->OD_v / C;
+	/* (= 1 - (v/C)^2, without the cancellation) */
+	wp->OD_inv_gamma2 = (1.0 - wp->OD_v_over_C) * (1.0 + wp->OD_v_over_C);
+	if ((wp->OD_v / C) > WARP_NEGLIGIBLE_BETA)
+		wp->effects |= WARP_FX_DEFORMATION;
+	wp->real_x = wp->OD_v * ctx->sim_time;
+
+	/* Variables for Doppler shift */
+	if ((v * ctx->percent_dopplershift / C) > WARP_NEGLIGIBLE_BETA) {
+		wp->DS_v_over_C = v * ctx->percent_dopplershift / C;
+		wp->DS_gamma = lorentz_factor( v * ctx->percent_dopplershift );
+		wp->effects |= WARP_FX_DOPPLER;
+	}
+	else {
+		wp->DS_v_over_C = 0.0;
+		wp->DS_gamma = 1.0;
+	}
+
+	/* Variables for headlight effect */
+	if ((v * ctx->percent_headlight / C) > WARP_NEGLIGIBLE_BETA) {
+		wp->HE_v_over_C = v * ctx->percent_headlight / C;
+		wp->HE_gamma = lorentz_factor( v * ctx->percent_headlight );
+		wp->effects |= WARP_FX_HEADLIGHT;
+	}
+	else {
+		wp->HE_v_over_C = 0.0;
+		wp->HE_gamma = 1.0;
+	}
+
+	wp->cam_pos = *cam_pos;
+	wp->interp_lut1 = normal_interp_lut1;
+	wp->interp_lut2 = normal_interp_lut2;
+	wp->dgamma_lut = ctx->dgamma_lut;
+	wp->dgamma_exp = ctx->dgamma_exp;
+	wp->dgamma_correct = ctx->dgamma_correct;
+}
+
+
+/* Warps the objects with the given constants (num_wps sets of them, cf.
+ * warp_job), across the worker threads, working out the gradients too if
+ * grads is not NULL, and only the vertex blocks flagged in blocks if that
+ * is not NULL. use_lc_cache may only be set for the vehicle objects,
+ * after update_contraction_cache( ) */
+static void
+run_warp( const warp_params *wp, int num_wps, ogl_object **objs, int num_objs, ogl_point **out_buffers, point **grads, unsigned char **blocks, int use_lc_cache )
+{
+	warp_job job;
+	int o, b;
+
+	if (blocks != NULL) {
+		for (o = 0; o < num_objs; o++) {
+			for (b = 0; b * WARP_CULL_BLOCK < objs[o]->num_vertices; b++)
+				num_blocks_warped += blocks[o][b] ? num_wps : 0;
+			num_blocks_total += (double)(num_wps * b);
+		}
+	}
+
+	job.wp = wp;
+	job.num_wps = num_wps;
+	job.objs = objs;
+	job.num_objs = num_objs;
+	job.out = out_buffers;
+	job.use_lc_cache = use_lc_cache;
+	job.grads = grads;
+	job.blocks = blocks;
+	warp_pool_run( objs, num_objs, warp_range, &job );
+}
+
+
+/* Returns TRUE if two sets of warp constants give the same results (the
+ * rest of the fields are derived from these). Positions get a little
+ * slack, as e.g. revolving a camera about itself recalculates its position
+ * from the target, which can disturb the last few bits */
+static int
+warp_keys_match( const warp_params *key1, const warp_params *key2 )
+{
+	double tol;
+
+	if ((key1->LC_gamma != key2->LC_gamma) || (key1->OD_v != key2->OD_v))
+		return FALSE;
+	if ((key1->DS_v_over_C != key2->DS_v_over_C) || (key1->HE_v_over_C != key2->HE_v_over_C))
+		return FALSE;
+	if ((key1->dgamma_correct != key2->dgamma_correct) || (key1->effects != key2->effects))
+		return FALSE;
+	if (key1->dgamma_exp != key2->dgamma_exp)
+		return FALSE;
+
+	tol = WARP_KEY_TOLERANCE * vehicle_extents.avg;
+	if (ABS(key1->real_x - key2->real_x) > tol)
+		return FALSE;
+	if (ABS(key1->cam_pos.x - key2->cam_pos.x) > tol)
+		return FALSE;
+	if (ABS(key1->cam_pos.y - key2->cam_pos.y) > tol)
+		return FALSE;
+	if (ABS(key1->cam_pos.z - key2->cam_pos.z) > tol)
+		return FALSE;
+
+	return TRUE;
+}
+
+
+/* Returns TRUE if two sets of constants differ in camera position only,
+ * i.e. they can go through a warp kernel together */
+static int
+warp_frames_match( const warp_params *wp1, const warp_params *wp2 )
+{
+	if ((wp1->effects != wp2->effects) || (wp1->LC_gamma != wp2->LC_gamma))
+		return FALSE;
+	if ((wp1->OD_v != wp2->OD_v) || (wp1->real_x != wp2->real_x))
+		return FALSE;
+	if ((wp1->DS_v_over_C != wp2->DS_v_over_C) || (wp1->HE_v_over_C != wp2->HE_v_over_C))
+		return FALSE;
+	if ((wp1->dgamma_correct != wp2->dgamma_correct) || (wp1->dgamma_lut != wp2->dgamma_lut))
+		return FALSE;
+	if (wp1->dgamma_exp != wp2->dgamma_exp)
+		return FALSE;
+
+	return TRUE;
+}
+
+
+/* Allocates a new warped view, with one array per vehicle object
+ * (NULL-terminated, as the object count may change before it is freed) */
+static warped_view *
+alloc_warped_view( void )
+{
+	warped_view *view;
+	ogl_point *pnts;
+	int o, v;
+
+	view = xmalloc( sizeof(warped_view) );
+	view->iarrays = xmalloc( (num_vehicle_objs + 1) * sizeof(ogl_point *) );
+	for (o = 0; o < num_vehicle_objs; o++) {
+		pnts = xmalloc( vehicle_objs[o]->num_vertices * sizeof(ogl_point) );
+		/* As in alloc_ogl_object( ) */
+		for (v = 0; v < vehicle_objs[o]->num_vertices; v++)
+			pnts[v].a = 1.0;
+		view->iarrays[o] = pnts;
+	}
+	view->iarrays[num_vehicle_objs] = NULL;
+	view->blocks = alloc_masks( FALSE );
+	memset( &view->key, 0, sizeof(warp_params) ); /* matches nothing */
+	view->num_cams = 1;
+	view->serial = ++last_view_serial;
+	view->grads = NULL;
+	view->base_dist = 0.0;
+	view->extrapolated = FALSE;
+
+	return view;
+}
+
+
+/* Sets a view up for an exact warp with the given constants. In
+ * interactive mode, returns where the gradients go (allocating them if
+ * need be), otherwise NULL */
+static point **
+prepare_warped_view( warped_view *view, const warp_params *wp )
+{
+	int o;
+
+	/* (nothing warped as yet) */
+	for (o = 0; view->blocks[o] != NULL; o++)
+		memset( view->blocks[o], 0, (vehicle_objs[o]->num_vertices + WARP_CULL_BLOCK - 1) / WARP_CULL_BLOCK );
+	view->key = *wp;
+	view->base = *wp;
+	view->serial = ++last_view_serial;
+	view->extrapolated = FALSE;
+	view->base_dist = 0.0;
+	if (!interactive)
+		return NULL;
+
+	/* (no extrapolating with the camera inside the vehicle) */
+	view->base_dist = vehicle_distance( &wp->cam_pos, wp );
+	if (view->base_dist <= 0.0)
+		return NULL;
+	if (view->grads == NULL) {
+		view->grads = xmalloc( (num_vehicle_objs + 1) * sizeof(point *) );
+		for (o = 0; o < num_vehicle_objs; o++)
+			view->grads[o] = xmalloc( vehicle_objs[o]->num_vertices * sizeof(point) );
+		view->grads[num_vehicle_objs] = NULL;
+	}
+
+	return view->grads;
+}
+
+
+/* Distance from a point to the vehicle's bounding box, as contracted and
+ * moved to its x-location by the given constants */
+static float
+vehicle_distance( const point *pos, const warp_params *wp )
+{
+	double xmin, xmax;
+	double dx, dy, dz;
+
+	xmin = vehicle_extents.xmin / wp->LC_gamma + wp->real_x;
+	xmax = vehicle_extents.xmax / wp->LC_gamma + wp->real_x;
+	dx = MAX(0.0, MAX(xmin - pos->x, pos->x - xmax));
+	dy = MAX(0.0, MAX(vehicle_extents.ymin - pos->y, pos->y - vehicle_extents.ymax));
+	dz = MAX(0.0, MAX(vehicle_extents.zmin - pos->z, pos->z - vehicle_extents.zmax));
+
+	return sqrt( SQR(dx) + SQR(dy) + SQR(dz) );
+}
+
+
+/* Interactive mode: brings a camera's view up to date with the given
+ * constants by first-order extrapolation from its last exact warp, if
+ * they differ from that in camera position and vehicle x-location only.
+ * The warped x-coordinates are all that depend on these (to first order,
+ * the Doppler shift and headlight effect do too, but colors are left as
+ * they were). The error is estimated from the movement d (relative to the
+ * distance to the vehicle) since the exact warp: the second-order term of
+ * optical deformation goes as beta/(1 - beta) * d^2, and a color change as
+ * beta*gamma * d. Returns TRUE if done, FALSE if an exact warp is needed */
+static int
+extrapolate_view( camera *cam, const warp_params *wp )
+{
+	warped_view *view = cam->view;
+	extrapolate_job job;
+	warp_params frame;
+	double d, beta, k;
+
+	if (!interactive || (view == NULL) || (view->base_dist <= 0.0))
+		return FALSE;
+	/* (another camera's view would go wrong) */
+	if (view->num_cams > 1)
+		return FALSE;
+	frame = *wp;
+	frame.real_x = view->base.real_x;
+	if (!warp_frames_match( &frame, &view->base ))
+		return FALSE;
+
+	d = ABS(wp->cam_pos.x - view->base.cam_pos.x);
+	d += ABS(wp->cam_pos.y - view->base.cam_pos.y);
+	d += ABS(wp->cam_pos.z - view->base.cam_pos.z);
+	d += ABS(wp->real_x - view->base.real_x);
+	d /= view->base_dist;
+	if (wp->effects & WARP_FX_DEFORMATION) {
+		beta = wp->OD_v / C;
+		if ((beta / (1.0 - beta) * SQR(d)) > WARP_EXTRAPOLATION_TOLERANCE) {
+			++num_extrapolation_limits;
+			return FALSE;
+		}
+	}
+	if (wp->effects & WARP_FX_COLOR) {
+		k = MAX(wp->DS_v_over_C * wp->DS_gamma, wp->HE_v_over_C * wp->HE_gamma);
+		if ((k * d) > WARP_EXTRAPOLATION_COLOR_TOLERANCE) {
+			++num_extrapolation_limits;
+			return FALSE;
+		}
+	}
+
+	/* (one job at a time) */
+	finish_ahead( );
+	job.view = view;
+	job.d_cam_x = wp->cam_pos.x - view->key.cam_pos.x;
+	job.d_cam_y = wp->cam_pos.y - view->key.cam_pos.y;
+	job.d_cam_z = wp->cam_pos.z - view->key.cam_pos.z;
+	job.d_real_x = wp->real_x - view->key.real_x;
+	warp_pool_run( vehicle_objs, num_vehicle_objs, extrapolate_range, &job );
+	view->key = *wp;
+	view->serial = ++last_view_serial;
+	view->extrapolated = TRUE;
+	++num_views_extrapolated;
+
+	return TRUE;
+}
+
+
+/* Extrapolates vertices [v0, v1) of an object's warped view. As warped x
+ * is x - v*t, and x less camera x is what t goes by, moving the vehicle
+ * along works like moving the camera back, plus the move itself. Called
+ * from the worker threads */
+static void
+extrapolate_range( int obj_id, int v0, int v1, void *data )
+{
+	const extrapolate_job *job = (const extrapolate_job *)data;
+	ogl_point *pnts;
+	const point *grads;
+	int vn;
+
+	pnts = job->view->iarrays[obj_id];
+	grads = job->view->grads[obj_id];
+	for (vn = v0; vn < v1; vn++)
+		pnts[vn].x += grads[vn].x * (job->d_cam_x - job->d_real_x) + grads[vn].y * job->d_cam_y + grads[vn].z * job->d_cam_z + job->d_real_x;
+}
+
+
+/* Drops a reference to a warped view (if not NULL), freeing it if no
+ * camera is using it anymore */
+static void
+unref_warped_view( warped_view *view )
+{
+	int o;
+
+	if (view == NULL)
+		return;
+	if (--view->num_cams > 0)
+		return;
+
+	for (o = 0; view->iarrays[o] != NULL; o++)
+		xfree( view->iarrays[o] );
+	xfree( view->iarrays );
+	free_masks( view->blocks );
+	if (view->grads != NULL) {
+		for (o = 0; view->grads[o] != NULL; o++)
+			xfree( view->grads[o] );
+		xfree( view->grads );
+	}
+	xfree( view );
+}
+
+
+/* Detaches a camera from its warped view (if any), freeing the latter
+ * if no other camera is using it */
+static void
+release_warped_view( camera *cam )
+{
+	unref_warped_view( cam->view );
+	cam->view = NULL;
+}
+
+
+/* Gets rid of both of a camera's views (no warp ahead may be under way) */
+static void
+discard_warped_views( camera *cam )
+{
+	release_warped_view( cam );
+	unref_warped_view( cam->next_view );
+	cam->next_view = NULL;
+	cam->next_ready = FALSE;
+	/* (the geometry may be about to change) */
+	if (cam->visible != NULL) {
+		free_masks( cam->visible );
+		cam->visible = NULL;
+	}
+}
+
+
+/* Makes the view warped ahead for a camera its current one. The old one
+ * is kept around for the next warp ahead, unless it is shared */
+static void
+flip_warped_views( camera *cam )
+{
+	warped_view *view;
+
+	view = cam->view;
+	cam->view = cam->next_view;
+	cam->next_view = NULL;
+	cam->next_ready = FALSE;
+	if ((view != NULL) && (view->num_cams == 1))
+		cam->next_view = view;
+	else
+		unref_warped_view( view );
+}
+
+
+/* Waits for the view being warped ahead (if any) to be done */
+static void
+finish_ahead( void )
+{
+	double t0;
+
+	if (ahead_cam == NULL)
+		return;
+
+	t0 = read_system_clock( );
+	warp_pool_wait( );
+	ahead_wait_t += read_system_clock( ) - t0;
+	ahead_cam = NULL;
+}
+
+
+/* Optical deformation: how far (v*t) the vehicle moves while the light
+ * from a vertex dx, dy, dz away from the camera (dyz2 = dy^2 + dz^2, dist2
+ * = dx^2 + dyz2) makes it to the camera. The textbook solve,
+ *	t = (dx*v - sqrt( C2*dist2 - dyz2*v2 )) / (v2 - C2)
+ * cancels catastrophically near c. Here it is taken in units of C, with
+ * the conjugate for dx > 0, so that either way only nonnegative terms are
+ * added up, which keeps it to within a few ulps in single precision for
+ * any velocity (see deform_precision_check( )). inv_gamma2 is 1 - beta^2,
+ * as worked out without the cancellation in double precision */
+static ALWAYS_INLINE float
+deform_dist( float dx, float dyz2, float dist2, float beta, float inv_gamma2 )
+{
+	float root;
+
+	root = sqrtf( SQR(dx) + inv_gamma2 * dyz2 );
+	if (dx > 0.0)
+		return beta * dist2 / (root + beta * dx);
+	else
+		return beta * (root - beta * dx) / inv_gamma2;
+}
+
+
+/* Normal interpolation factor for an intensity excess of s (>= 0), i.e.
+ * 2/pi * atan( s ), by way of 1 - 2/pi * atan( 1/s ) for s > 1. This is
+ * what normal_interp_lut1/2 hold (cf. poly_precision_check( )) */
+static ALWAYS_INLINE float
+interp_factor_poly( float s )
+{
+	float x, x2, k;
+
+	x = (s > 1.0f) ? (1.0f / s) : s;
+	x2 = SQR(x);
+	k = WARP_ATAN_P3 + x2 * WARP_ATAN_P4;
+	k = WARP_ATAN_P2 + x2 * k;
+	k = WARP_ATAN_P1 + x2 * k;
+	k = x * (WARP_ATAN_P0 + x2 * k);
+
+	return (s > 1.0f) ? (1.0f - k) : k;
+}
+
+
+/* x^k for x in [0, 1] (display gamma correction, as in dgamma_lut), as
+ * 2^(k * log2( x )). log2 is taken from the exponent bits and a polynomial
+ * in the mantissa, 2^ the other way around */
+static ALWAYS_INLINE float
+pow01_poly( float x, float k )
+{
+	union { float f; int i; } u;
+	float t, y, p;
+	int e;
+
+	/* log2( x ) = e + log2( 1 + t ) */
+	u.f = MAX(x, 1E-20f);
+	e = ((u.i >> 23) & 0xFF) - 127;
+	u.i = (u.i & 0x007FFFFF) | 0x3F800000;
+	t = u.f - 1.0f;
+	p = WARP_LOG2_P3 + t * WARP_LOG2_P4;
+	p = WARP_LOG2_P2 + t * p;
+	p = WARP_LOG2_P1 + t * p;
+	p = WARP_LOG2_P0 + t * p;
+	y = k * ((float)e + t * p);
+
+	/* 2^y = 2^e * 2^t, t in [0, 1) */
+	y = MAX(y, -126.0f);
+	e = (int)y;
+	e -= ((float)e > y); /* (floor) */
+	t = y - (float)e;
+	p = WARP_EXP2_P2 + t * WARP_EXP2_P3;
+	p = WARP_EXP2_P1 + t * p;
+	p = WARP_EXP2_P0 + t * p;
+	u.i = (e + 127) << 23;
+
+	return (1.0f + t * p) * u.f;
+}
+
+
+/* Lorentz contraction of a normal (renormalized) */
+static ALWAYS_INLINE void
+contract_normal( point *normal, double LC_gamma )
+{
+	double dx, dy, dz;
+	float len2, len;
+
+	dx = normal->x;
+	dy = normal->y / LC_gamma;
+	dz = normal->z / LC_gamma;
+
+	/* Renormalize the normal */
+	len2 = SQR(dx) + SQR(dy) + SQR(dz);
+#if WARP_POLY_APPROX
+	len = sqrtf( len2 );
+#elif USE_LOOKUP_TABLES
+#ifdef DEBUG
+	if (len2 > 1.001) {
+		printf( "ERROR: warp( ): normal length > 1.0 !!!\n" );
+		fflush( stdout );
+		len2 = 1.0;
+	}
+#endif /* DEBUG */
+	len = sqrt01_lut[(int)(len2 * LUT_RES)];
+#else
+	len = sqrt( len2 );
+#endif /* not WARP_POLY_APPROX, USE_LOOKUP_TABLES */
+	if (len < 1E-6)
+		len = 1.0;
+	normal->x = dx / len;
+	normal->y = dy / len;
+	normal->z = dz / len;
+}
+
+
+/* Lorentz contraction depends on velocity and percent_contraction alone,
+ * and does not change as the camera moves about. So each object keeps a
+ * contracted copy of its geometry (laid out for the kernel in use), which
+ * is only redone when LC_gamma changes; jobs with use_lc_cache set read
+ * it instead of contracting anew. No job may be under way that reads it */
+static void
+update_contraction_cache( const warp_params *wp )
+{
+	ogl_object *obj;
+	warp_job job;
+	double t0;
+	int num_stale = 0;
+	int o;
+
+	if (!(wp->effects & WARP_FX_CONTRACTION))
+		return;
+
+	for (o = 0; o < num_vehicle_objs; o++) {
+		obj = vehicle_objs[o];
+		if (obj->lc_gamma == wp->LC_gamma)
+			continue;
+		++num_stale;
+#ifdef WARP_SIMD_X86
+		if (use_simd && (obj->soa0 != NULL)) {
+			if (obj->soa_lc == NULL)
+				obj->soa_lc = xmalloc_aligned( 6 * obj->soa_stride * sizeof(float), 32 );
+			continue;
+		}
+#endif
+		if (obj->vertices_lc == NULL) {
+			obj->vertices_lc = xmalloc( obj->num_vertices * sizeof(point) );
+			obj->normals_lc = xmalloc( obj->num_vertices * sizeof(point) );
+		}
+	}
+	if (num_stale == 0) {
+		++num_lc_reuses;
+		return;
+	}
+
+	t0 = read_system_clock( );
+	finish_ahead( );
+	job.wp = wp;
+	job.objs = vehicle_objs;
+	warp_pool_run( vehicle_objs, num_vehicle_objs, contract_range, &job );
+	for (o = 0; o < num_vehicle_objs; o++)
+		vehicle_objs[o]->lc_gamma = wp->LC_gamma;
+	lc_build_t += read_system_clock( ) - t0;
+	++num_lc_builds;
+}
+
+
+/* Contracts vertices [v0, v1) of an object into its cache (the kernel in
+ * use determining the layout). Called from the worker threads */
+static void
+contract_range( int obj_id, int v0, int v1, void *data )
+{
+	const warp_job *job = (const warp_job *)data;
+	ogl_object *obj;
+	double LC_gamma;
+	int vn;
+
+	obj = job->objs[obj_id];
+	LC_gamma = job->wp->LC_gamma;
+	if (obj->lc_gamma == LC_gamma)
+		return;
+
+#ifdef WARP_SIMD_X86
+	if (use_simd && (obj->soa0 != NULL)) {
+		/* (the last range takes in the padding) */
+		if (v1 == obj->num_vertices)
+			v1 = obj->soa_stride;
+		warp_contract_avx2( obj, v0, v1, LC_gamma );
+		return;
+	}
+#endif
+	for (vn = v0; vn < v1; vn++) {
+		obj->vertices_lc[vn].x = obj->vertices0[vn].x / LC_gamma;
+		obj->vertices_lc[vn].y = obj->vertices0[vn].y;
+		obj->vertices_lc[vn].z = obj->vertices0[vn].z;
+		obj->normals_lc[vn] = obj->normals0[vn];
+		contract_normal( &obj->normals_lc[vn], LC_gamma );
+	}
+}
+
+
+/* WARP_DISTORT_CAMERAS: brings the views of all cameras due for a redraw
+ * up to date, with the ones that need warping done in a single job. As
+ * their constants differ in camera position only, the kernels go through
+ * the vertices once for all of them. With the pipeline on, a lone camera
+ * is left to the usual (stale view + warp ahead) route; with several, the
+ * batch costs little more than warping one, so they all get a fresh view */
+static int
+distort_cameras( const warp_params *wp )
+{
+	static camera **cams = NULL;
+	static warp_params *wps = NULL;
+	static ogl_point **outs = NULL;
+	static point **grad_outs = NULL;
+	static int max_cams = 0, max_outs = 0;
+	camera *cam;
+	warped_view *view;
+	point **grads;
+	unsigned char **blocks;
+	int num_batch = 0, num_todo = 0;
+	int i, j, o, b, num_blocks;
+
+	if (max_cams < num_cams) {
+		max_cams = num_cams;
+		cams = xrealloc( cams, max_cams * sizeof(camera *) );
+		wps = xrealloc( wps, max_cams * sizeof(warp_params) );
+	}
+	if (max_outs < num_cams * num_vehicle_objs) {
+		max_outs = num_cams * num_vehicle_objs;
+		outs = xrealloc( outs, max_outs * sizeof(ogl_point *) );
+		grad_outs = xrealloc( grad_outs, max_outs * sizeof(point *) );
+	}
+
+	/* Which cameras' views are out of date? */
+	finish_ahead( );
+	for (i = 0; i < num_cams; i++) {
+		cam = usr_cams[i];
+		if (!cam->redraw)
+			continue;
+		if (cam->next_ready)
+			flip_warped_views( cam );
+		wps[num_todo] = *wp;
+		wps[num_todo].cam_pos = cam->pos;
+		if ((cam->view != NULL) && warp_keys_match( &wps[num_todo], &cam->view->key ))
+			continue;
+		if (extrapolate_view( cam, &wps[num_todo] ))
+			continue;
+		cams[num_todo++] = cam;
+	}
+	if ((num_todo == 0) || ((pipeline_depth > 1) && (num_todo < 2)))
+		return 0;
+
+	for (i = 0; i < num_todo; i++) {
+		cam = cams[i];
+		/* Cameras at the same position can share a view (which
+		 * includes one set up earlier in this batch) */
+		for (j = 0; j < num_cams; j++) {
+			view = usr_cams[j]->view;
+			if ((view == NULL) || (view == cam->view))
+				continue;
+			if (warp_keys_match( &wps[i], &view->key ))
+				break;
+		}
+		if (j < num_cams) {
+			release_warped_view( cam );
+			cam->view = view;
+			++view->num_cams;
+			++num_views_shared;
+			continue;
+		}
+
+		/* Warp into a view of this camera's own */
+		if ((cam->view != NULL) && (cam->view->num_cams > 1))
+			release_warped_view( cam );
+		if (cam->view == NULL)
+			cam->view = alloc_warped_view( );
+		grads = prepare_warped_view( cam->view, &wps[i] );
+		cull_meshlets( cam, &wps[i], cam->view->blocks );
+		cams[num_batch] = cam;
+		wps[num_batch] = wps[i];
+		for (o = 0; o < num_vehicle_objs; o++) {
+			outs[num_batch * num_vehicle_objs + o] = cam->view->iarrays[o];
+			grad_outs[num_batch * num_vehicle_objs + o] = (grads != NULL) ? grads[o] : NULL;
+		}
+		++num_batch;
+	}
+	if (num_batch == 0)
+		return 0;
+
+	/* The kernels warp the same vertices for the whole batch, so
+	 * every view gets what any of the cameras can see */
+	blocks = cams[0]->view->blocks;
+	for (o = 0; o < num_vehicle_objs; o++) {
+		num_blocks = (vehicle_objs[o]->num_vertices + WARP_CULL_BLOCK - 1) / WARP_CULL_BLOCK;
+		for (i = 1; i < num_batch; i++) {
+			for (b = 0; b < num_blocks; b++)
+				blocks[o][b] |= cams[i]->view->blocks[o][b];
+		}
+		for (i = 1; i < num_batch; i++)
+			memcpy( cams[i]->view->blocks[o], blocks[o], num_blocks );
+	}
+
+	update_contraction_cache( wp );
+	run_warp( wps, num_batch, vehicle_objs, num_vehicle_objs, outs, interactive ? grad_outs : NULL, blocks, TRUE );
+	ui_ctx.wp = *wp;
+	num_views_warped += num_batch;
+	++num_camera_batches;
+
+	return num_batch;
+}
+
+
+/* Allocates zeroed masks for the vehicle objects, with an entry for each
+ * meshlet if per_meshlet is set, or else for each WARP_CULL_BLOCK vertices
+ * (NULL-terminated, as with the arrays of a warped view) */
+static unsigned char **
+alloc_masks( int per_meshlet )
+{
+	unsigned char **masks;
+	int o, n;
+
+	masks = xmalloc( (num_vehicle_objs + 1) * sizeof(unsigned char *) );
+	for (o = 0; o < num_vehicle_objs; o++) {
+		if (per_meshlet)
+			n = vehicle_objs[o]->num_meshlets;
+		else
+			n = (vehicle_objs[o]->num_vertices + WARP_CULL_BLOCK - 1) / WARP_CULL_BLOCK;
+		masks[o] = xmalloc( MAX(1, n) );
+		memset( masks[o], 0, MAX(1, n) );
+	}
+	masks[num_vehicle_objs] = NULL;
+
+	return masks;
+}
+
+
+static void
+free_masks( unsigned char **masks )
+{
+	int o;
+
+	for (o = 0; masks[o] != NULL; o++)
+		xfree( masks[o] );
+	xfree( masks );
+}
+
+
+/* Bounds of a meshlet's vertices once warped with the given constants.
+ * Only x changes; it is Lorentz contracted and moved along with the
+ * vehicle, and then, with optical deformation, shifted by an amount that
+ * grows with both x and the distance from the camera's x-axis. So the
+ * warped x-extremes are found at the corners of the range of each */
+static void
+warped_bounds( const ogl_meshlet *ml, const warp_params *wp, point *min, point *max )
+{
+	float xa, xb, dx, x;
+	float dyz2[2], dy, dz;
+	int i, j;
+
+	*min = ml->min;
+	*max = ml->max;
+	xa = ml->min.x;
+	xb = ml->max.x;
+	if (wp->effects & WARP_FX_CONTRACTION) {
+		xa /= wp->LC_gamma;
+		xb /= wp->LC_gamma;
+	}
+	min->x = xa + wp->real_x;
+	max->x = xb + wp->real_x;
+	if (!(wp->effects & WARP_FX_DEFORMATION))
+		return;
+
+	/* Nearest and farthest squared distances in y & z */
+	dy = MAX(0.0, MAX(ml->min.y - wp->cam_pos.y, wp->cam_pos.y - ml->max.y));
+	dz = MAX(0.0, MAX(ml->min.z - wp->cam_pos.z, wp->cam_pos.z - ml->max.z));
+	dyz2[0] = SQR(dy) + SQR(dz);
+	dy = MAX(ABS(ml->min.y - wp->cam_pos.y), ABS(ml->max.y - wp->cam_pos.y));
+	dz = MAX(ABS(ml->min.z - wp->cam_pos.z), ABS(ml->max.z - wp->cam_pos.z));
+	dyz2[1] = SQR(dy) + SQR(dz);
+
+	min->x = 1E30;
+	max->x = -1E30;
+	for (i = 0; i < 2; i++) {
+		dx = (i ? xb : xa) + (float)(wp->real_x - wp->cam_pos.x);
+		for (j = 0; j < 2; j++) {
+			x = wp->cam_pos.x + (dx - deform_dist( dx, dyz2[j], SQR(dx) + dyz2[j], wp->OD_v_over_C, wp->OD_inv_gamma2 ));
+			min->x = MIN(min->x, x);
+			max->x = MAX(max->x, x);
+		}
+	}
+}
+
+
+/* Frustum culling: flags the meshlets of the vehicle objects that are in
+ * the camera's view (widened by WARP_CULL_MARGIN) in cam->visible, as they
+ * come out of a warp with the given constants, and the vertex blocks they
+ * use in need (if not NULL). Everything counts as visible if the camera
+ * looks straight up or down, or the constants are not proper ones */
+static void
+cull_meshlets( camera *cam, const warp_params *wp, unsigned char **need )
+{
+	ogl_object *obj;
+	ogl_meshlet *ml;
+	point f, r, u;
+	point planes[5];
+	point min, max, d;
+	double len, tx, ty, far;
+	float dist;
+	int all_in;
+	int o, m, p, b;
+
+	if (cam->visible == NULL) {
+		for (o = 0; o < num_vehicle_objs; o++) {
+			if (vehicle_objs[o]->meshlets == NULL)
+				update_ogl_object_meshlets( vehicle_objs[o] );
+		}
+		cam->visible = alloc_masks( TRUE );
+	}
+
+	/* Camera axes: f(orward), r(ight) and u(p) */
+	f.x = cam->target.x - cam->pos.x;
+	f.y = cam->target.y - cam->pos.y;
+	f.z = cam->target.z - cam->pos.z;
+	len = sqrt( SQR(f.x) + SQR(f.y) + SQR(f.z) );
+	all_in = (len < 1E-6) || (wp->LC_gamma == 0.0);
+	if (!all_in) {
+		f.x /= len;
+		f.y /= len;
+		f.z /= len;
+		r.x = f.y;
+		r.y = - f.x;
+		r.z = 0.0;
+		len = sqrt( SQR(r.x) + SQR(r.y) );
+		all_in = (len < 1E-3);
+		r.x /= MAX(len, 1E-3);
+		r.y /= MAX(len, 1E-3);
+	}
+
+	/* (no planes needed if everything is in) */
+	if (!all_in) {
+		u.x = r.y * f.z - r.z * f.y;
+		u.y = r.z * f.x - r.x * f.z;
+		u.z = r.x * f.y - r.y * f.x;
+
+		/* Inward normals of the side planes (through the camera), as in
+		 * ogl_draw( ), and outward normal of the far plane */
+		tx = tan( RAD(cam->fov) / 2.0 + WARP_CULL_MARGIN );
+		ty = tan( atan( tan( RAD(cam->fov) / 2.0 ) * (double)cam->height / (double)MAX(1, cam->width) ) + WARP_CULL_MARGIN );
+		for (p = 0; p < 2; p++) {
+			planes[p].x = tx * f.x + (p ? r.x : - r.x);
+			planes[p].y = tx * f.y + (p ? r.y : - r.y);
+			planes[p].z = tx * f.z + (p ? r.z : - r.z);
+			planes[p + 2].x = ty * f.x + (p ? u.x : - u.x);
+			planes[p + 2].y = ty * f.y + (p ? u.y : - u.y);
+			planes[p + 2].z = ty * f.z + (p ? u.z : - u.z);
+		}
+		planes[4].x = - f.x;
+		planes[4].y = - f.y;
+		planes[4].z = - f.z;
+		far = cam->far_clip * (1.0 + WARP_CULL_MARGIN);
+	}
+
+	for (o = 0; o < num_vehicle_objs; o++) {
+		obj = vehicle_objs[o];
+		for (m = 0; m < obj->num_meshlets; m++) {
+			ml = &obj->meshlets[m];
+			cam->visible[o][m] = TRUE;
+			if (!all_in) {
+				warped_bounds( ml, wp, &min, &max );
+				/* Box center (relative to the camera) and
+				 * half-size */
+				d.x = 0.5 * (min.x + max.x) - cam->pos.x;
+				d.y = 0.5 * (min.y + max.y) - cam->pos.y;
+				d.z = 0.5 * (min.z + max.z) - cam->pos.z;
+				max.x = 0.5 * (max.x - min.x);
+				max.y = 0.5 * (max.y - min.y);
+				max.z = 0.5 * (max.z - min.z);
+				for (p = 0; p < 5; p++) {
+					/* Farthest the box reaches along the normal */
+					dist = planes[p].x * d.x + planes[p].y * d.y + planes[p].z * d.z;
+					dist += ABS(planes[p].x) * max.x + ABS(planes[p].y) * max.y + ABS(planes[p].z) * max.z;
+					if (p == 4)
+						dist += far;
+					if (dist < 0.0) {
+						cam->visible[o][m] = FALSE;
+						break;
+					}
+				}
+			}
+			if ((need == NULL) || !cam->visible[o][m])
+				continue;
+			for (b = ml->v0 / WARP_CULL_BLOCK; b * WARP_CULL_BLOCK < ml->v1; b++)
+				need[o][b] = TRUE;
+		}
+	}
+}
+
+
+/* WARP_CULL: culls a camera's view (as it will be drawn, i.e. with the
+ * constants it was warped or extrapolated with), warping the parts in
+ * sight that were left out until now. A meshlet only gets drawn if all
+ * of its vertices are in the view. Returns TRUE if any warping was done */
+static int
+cover_view( camera *cam )
+{
+	unsigned char **need;
+	warped_view *view = cam->view;
+	point **grads = NULL;
+	int missing = FALSE;
+	int num_blocks, complete;
+	int o, m, b;
+
+	if (view == NULL)
+		return FALSE;
+
+	if (view->key.LC_gamma == 0.0) {
+		/* Not a proper key (see WARP_INTERACTIVE), so whatever
+		 * was warped will have to do */
+		cull_meshlets( cam, &view->key, NULL );
+	}
+	else {
+		need = alloc_masks( FALSE );
+		cull_meshlets( cam, &view->key, need );
+		for (o = 0; o < num_vehicle_objs; o++) {
+			num_blocks = (vehicle_objs[o]->num_vertices + WARP_CULL_BLOCK - 1) / WARP_CULL_BLOCK;
+			for (b = 0; b < num_blocks; b++) {
+				need[o][b] = need[o][b] && !view->blocks[o][b];
+				missing |= need[o][b];
+				num_blocks_late += need[o][b];
+			}
+		}
+		if (missing) {
+			finish_ahead( );
+			if (interactive && (view->base_dist > 0.0))
+				grads = view->grads;
+			run_warp( &view->key, 1, vehicle_objs, num_vehicle_objs, view->iarrays, grads, need, TRUE );
+			for (o = 0; o < num_vehicle_objs; o++) {
+				num_blocks = (vehicle_objs[o]->num_vertices + WARP_CULL_BLOCK - 1) / WARP_CULL_BLOCK;
+				for (b = 0; b < num_blocks; b++)
+					view->blocks[o][b] |= need[o][b];
+			}
+			view->serial = ++last_view_serial;
+		}
+		free_masks( need );
+	}
+
+	/* Only meshlets warped in full (the view may be out of date) */
+	for (o = 0; o < num_vehicle_objs; o++) {
+		for (m = 0; m < vehicle_objs[o]->num_meshlets; m++) {
+			complete = cam->visible[o][m];
+			for (b = vehicle_objs[o]->meshlets[m].v0 / WARP_CULL_BLOCK; complete && (b * WARP_CULL_BLOCK < vehicle_objs[o]->meshlets[m].v1); b++)
+				complete = view->blocks[o][b];
+			cam->visible[o][m] = complete;
+			num_meshlets_drawn += complete;
+		}
+		num_meshlets_total += vehicle_objs[o]->num_meshlets;
+	}
 
-	case WARP_OPTICAL_DEFORMATION:
-		do_optical_deformation = message2;
-		if (do_optical_deformation)
-			transition( &percent_deformation, FALSE, TRANS_SIGMOID, 4.0, 1.0, -1 );
-		else
-			transition( &percent_deformation, FALSE, TRANS_SIGMOID, 4.0, 0.0, -1 );
-		return 0;
+	return missing;
+}
 
-	case WARP_HEADLIGHT_EFFECT:
-		do_headlight_effect = message2;
-		if (do_headlight_effect)
-			transition( &percent_headlight, FALSE, TRANS_SIGMOID, 4.0, 1.0, -1 );
-		else
-			transition( &percent_headlight, FALSE, TRANS_SIGMOID, 4.0, 0.0, -1 );
-		return 0;
 
-	case WARP_DOPPLER_SHIFT:
-		do_doppler_shift = message2;
-		if (do_doppler_shift)
-			transition( &percent_dopplershift, FALSE, TRANS_SIGMOID, 4.0, 1.0, -1 );
-		else
-			transition( &percent_dopplershift, FALSE, TRANS_SIGMOID, 4.0, 0.0, -1 );
-		return 0;
+/* Warps vertices [v0, v1) of an object, or those of them in the vertex
+ * blocks the job asks for, if it does (runs of these go to warp_blocks( )
+ * in one piece). This gets called from the worker threads */
+static void
+warp_range( int obj_id, int v0, int v1, void *data )
+{
+	const warp_job *job = (const warp_job *)data;
+	const unsigned char *mask;
+	int va, vb;
 
-	case QUERY:
-		switch (message2) {
-		case WARP_LORENTZ_CONTRACTION:
-			return do_lorentz_contraction;
+	if (job->blocks == NULL) {
+		warp_blocks( job, obj_id, v0, v1 );
+		return;
+	}
 
-		case WARP_OPTICAL_DEFORMATION:
-			return do_optical_deformation;
+	/* (v0 is on a block boundary, as WARP_CULL_BLOCK
+	 * divides WARP_CHUNK_SIZE) */
+	mask = job->blocks[obj_id];
+	for (va = v0; va < v1; va = vb) {
+		vb = va;
+		while ((vb < v1) && mask[vb / WARP_CULL_BLOCK])
+			vb = MIN(v1, vb + WARP_CULL_BLOCK);
+		if (vb > va)
+			warp_blocks( job, obj_id, va, vb );
+		else
+			vb = MIN(v1, va + WARP_CULL_BLOCK);
+	}
+}
 
-		case WARP_HEADLIGHT_EFFECT:
-			return do_headlight_effect;
 
-		case WARP_DOPPLER_SHIFT:
-			return do_doppler_shift;
+/* Warps vertices [v0, v1) of an object, with each of the job's sets of
+ * constants in turn (the range is small enough to stay in cache between
+ * them), using whichever kernel is in use. Consecutive sets that differ in
+ * camera position only are handed to the kernel together, so it can share
+ * the work that does not depend on it */
+static void
+warp_blocks( const warp_job *job, int obj_id, int v0, int v1 )
+{
+	const warp_params *wp;
+	ogl_object *obj;
+	ogl_point *outs[WARP_MAX_CAMERA_BATCH];
+	point *grads;
+	int effects;
+	int lc;
+	int i, n, c;
+
+	obj = job->objs[obj_id];
+	for (i = 0; i < job->num_wps; i += n) {
+		n = 0;
+		do {
+			if (job->out != NULL)
+				outs[n] = job->out[(i + n) * job->num_objs + obj_id];
+			else
+				outs[n] = obj->iarrays;
+			++n;
+		} while ((i + n < job->num_wps) && (n < WARP_MAX_CAMERA_BATCH) && warp_frames_match( &job->wp[i], &job->wp[i + n] ));
+
+		/* With the contracted geometry at hand, that effect
+		 * amounts to reading it instead of the original */
+		wp = &job->wp[i];
+		effects = wp->effects;
+		lc = job->use_lc_cache && (effects & WARP_FX_CONTRACTION) && (obj->lc_gamma == wp->LC_gamma);
+		if (lc)
+			effects &= ~WARP_FX_CONTRACTION;
+
+		if (job->grads != NULL) {
+			/* (while the chunk is in cache) */
+			for (c = 0; c < n; c++) {
+				grads = job->grads[(i + c) * job->num_objs + obj_id];
+				if (grads != NULL)
+					warp_gradients( obj, grads, v0, v1, &job->wp[i + c] );
+			}
 		}
-		return 0;
 
-	case INITIALIZE:
-#if USE_LOOKUP_TABLES
-		/* Initialize look-up tables */
-		for (i = 0; i <= LUT_RES; i++) {
-			/* Normal interpolation factor tables
-			 * Table 1 handles [0, 1] input range */
-			normal_interp_lut1[i] = DEG(atan( (double)i / LUT_RES )) / 90.0;
-			/* Table 2 handles (1, inf.) (via reciprocal) */
-			if (i > 0)
-				normal_interp_lut2[i] = DEG(atan( LUT_RES / (double)i )) / 90.0;
-			/* Square root table for [0, 1] range */
-			sqrt01_lut[i] = sqrt( (double)i / LUT_RES );
-		}
-		normal_interp_lut2[0] = 1.0;
-#endif /* USE_LOOKUP_TABLES */
-		return 0;
-
-	default:
-#ifdef DEBUG
-		crash( "warp( ): invalid message" );
+#ifdef WARP_SIMD_X86
+		if (use_simd && (obj->soa0 != NULL)) {
+			warp_kernel_avx2_multi( obj, lc ? obj->soa_lc : obj->soa0, outs, v0, v1, wp, n, effects );
+			continue;
+		}
 #endif
-		return 0;
+		if (lc)
+			warp_kernel_scalar_multi( obj, obj->vertices_lc, obj->normals_lc, outs, v0, v1, wp, n, effects );
+		else
+			warp_kernel_scalar_multi( obj, obj->vertices0, obj->normals0, outs, v0, v1, wp, n, effects );
 	}
+}
 
-	/* Variables for Lorentz contraction */
-	LC_gamma = lorentz_factor( velocity * percent_contraction );
 
-	/* Variables for optical deformation */
-	OD_v = MAX(1.0, velocity * percent_deformation);
-	OD_v2 = SQR(OD_v);
-	OD_v2_min_C2 = OD_v2 - C2;
+/* Works out d(warped x)/d(camera position) for vertices [v0, v1) of an
+ * object, as warped with the given constants (cf. extrapolate_view( )).
+ * With dx, dy, dz from the camera to the (contracted) vertex, and R the
+ * square root in the time of flight t,
+ *	dx'/dcam = v * ((v - c^2*dx/R) / (v^2 - c^2), dy/R, dz/R)
+ * Called from the worker threads */
+static void
+warp_gradients( ogl_object *obj, point *grads, int v0, int v1, const warp_params *wp )
+{
+	double v = wp->OD_v;
+	double dx, dy, dz;
+	double dyz2, R;
+	int vn;
 
-	/* Simulation time (and x-location) depend on effective velocity
-	 * used for optical deformation */
-	warp_time( NIL, NIL, OD_v, WARP_UPDATE_TIME_T );
-	vehicle_real_x = OD_v * cur_time_t;
+	if (!(wp->effects & WARP_FX_DEFORMATION)) {
+		memset( &grads[v0], 0, (v1 - v0) * sizeof(point) );
+		return;
+	}
 
-	/* Variables for Doppler shift */
-	DS_v_over_C = velocity * percent_dopplershift / C;
-	DS_gamma = lorentz_factor( velocity * percent_dopplershift );
+	for (vn = v0; vn < v1; vn++) {
+		dx = obj->vertices0[vn].x / wp->LC_gamma + wp->real_x - wp->cam_pos.x;
+		dy = obj->vertices0[vn].y - wp->cam_pos.y;
+		dz = obj->vertices0[vn].z - wp->cam_pos.z;
+		dyz2 = SQR(dy) + SQR(dz);
+		R = sqrt( C2 * (SQR(dx) + dyz2) - wp->OD_v2 * dyz2 );
+		R = MAX(R, 1E-9);
+		grads[vn].x = v * (v - C2 * dx / R) / wp->OD_v2_min_C2;
+		grads[vn].y = v * dy / R;
+		grads[vn].z = v * dz / R;
+	}
+}
 
-	/* Variables for headlight effect */
-	HE_v_over_C = velocity * percent_headlight / C;
-	HE_gamma = lorentz_factor( velocity * percent_headlight );
 
-	for (o = 0; o < num_vehicle_objs; o++) {
-		obj = vehicle_objs[o];
-		/* "vn" is the counter instead of "v", to avoid
-		 * possible confusion with velocity variables */
-		for (vn = 0; vn < obj->num_vertices; vn++) {
-			/* Load vertex location */
-			vertex.x = obj->vertices0[vn].x;
-			vertex.y = obj->vertices0[vn].y;
-			vertex.z = obj->vertices0[vn].z;
-			/* Load vertex normal direction */
-			normal.x = obj->normals0[vn].x;
-			normal.y = obj->normals0[vn].y;
-			normal.z = obj->normals0[vn].z;
-			/* (Re)load base RGB color */
-			color.r = obj->color0.r;
-			color.g = obj->color0.g;
-			color.b = obj->color0.b;
-
-			/**** RELATIVISTIC GEOMETRY TRANSFORMS ****/
-
-			/* Do x-coordinate work in double precision */
-			d_vertex_x = vertex.x;
-
-			/** Lorentz contraction **/
-			d_vertex_x /= LC_gamma;
+/* The reference (scalar) warp kernel. Warps vertices [v0, v1) of the given
+ * object (read from vertices[ ] and normals[ ], i.e. its vertices0 and
+ * normals0 unless they are the contracted copy) as seen from each of
+ * num_wps cameras, storing the results in the
+ * corresponding elements of outs[0..num_wps-1][ ]. The sets of constants
+ * in wps[ ] must only differ in camera position (cf. warp_frames_match( )),
+ * as the camera-independent work (Lorentz contraction) is done only once
+ * per vertex, with wps[0]. Only the effects in fx (WARP_FX_* bits) are
+ * applied; this is always called with a constant fx, so each variant below
+ * is compiled with the code for the other effects left out */
+static ALWAYS_INLINE void
+warp_kernel_scalar_fx( ogl_object *obj, const point *vertices, const point *normals, ogl_point **outs, int v0, int v1, const warp_params *wps, int num_wps, const int fx )
+{
+	const warp_params *wp0 = &wps[0];
+	const warp_params *wp;
+	ogl_point *pnt;
+	point vertex;
+	point normal, cnormal;
+	rgb_color color;
+	rgb_color base_color;
+	rgb_color in_ray;
+	float x_lc, real_x, x;
+	float dx = 0.0, dy = 0.0, dz = 0.0;
+	float dyz2, dist2 = 0.0;
+	float cos_alpha_n, cos_alpha_c;
+	float freq_ratio;
+	float inten_ratio;
+	float intensity;
+	float len;
+	float k;
+	int vn, c;
+#if !WARP_POLY_APPROX && USE_LOOKUP_TABLES
+	int i;
+#endif
+
+	if (!(fx & WARP_FX_COLOR)) {
+		/* Without Doppler shift and headlight effect, the color
+		 * of the whole object stays as is (and as it is never
+		 * brighter than I(1,1,1), the normals do too) */
+		base_color.r = MIN(1.0, obj->color0.r);
+		base_color.g = MIN(1.0, obj->color0.g);
+		base_color.b = MIN(1.0, obj->color0.b);
+		if (wp0->dgamma_correct) {
+#if WARP_POLY_APPROX
+			base_color.r = pow01_poly( base_color.r, wp0->dgamma_exp );
+			base_color.g = pow01_poly( base_color.g, wp0->dgamma_exp );
+			base_color.b = pow01_poly( base_color.b, wp0->dgamma_exp );
+#else
+			base_color.r = wp0->dgamma_lut[(int)(base_color.r * LUT_RES)];
+			base_color.g = wp0->dgamma_lut[(int)(base_color.g * LUT_RES)];
+			base_color.b = wp0->dgamma_lut[(int)(base_color.b * LUT_RES)];
+#endif
+		}
+	}
+
+	/* "vn" is the counter instead of "v", to avoid
+	 * possible confusion with velocity variables */
+	for (vn = v0; vn < v1; vn++) {
+		/* Load vertex location */
+		vertex.x = vertices[vn].x;
+		vertex.y = vertices[vn].y;
+		vertex.z = vertices[vn].z;
+		/* Load vertex normal direction */
+		normal.x = normals[vn].x;
+		normal.y = normals[vn].y;
+		normal.z = normals[vn].z;
+
+		/**** RELATIVISTIC GEOMETRY TRANSFORMS ****/
+
+		/** Lorentz contraction **/
+		x_lc = vertex.x;
+		if (fx & WARP_FX_CONTRACTION) {
+			x_lc = vertex.x / wp0->LC_gamma;
 
 			/* Adjust normal accordingly */
-			dx = normal.x;
-			dy = normal.y / LC_gamma;
-			dz = normal.z / LC_gamma;
+			contract_normal( &normal, wp0->LC_gamma );
+		}
 
-			/* Renormalize the normal */
-			len2 = SQR(dx) + SQR(dy) + SQR(dz);
-#if USE_LOOKUP_TABLES
-#ifdef DEBUG
-			if (len2 > 1.001) {
-				printf( "ERROR: warp( ): normal length > 1.0 !!!\n" );
-				fflush( stdout );
-				len2 = 1.0;
+		/* Move object to its "real" x-position */
+		real_x = x_lc + wp0->real_x;
+
+		/* The rest depends on the camera position, and is done
+		 * for each camera in turn while the vertex is at hand */
+		for (c = 0; c < num_wps; c++) {
+			wp = &wps[c];
+			x = real_x;
+			cnormal = normal;
+
+			if (fx & (WARP_FX_DEFORMATION | WARP_FX_COLOR)) {
+				/* Obtain xyz deltas (camera to vertex). The
+				 * vehicle's x-position may be far larger than
+				 * it is, so the camera is subtracted first */
+				dx = x_lc + (float)(wp->real_x - wp->cam_pos.x);
+				dy = vertex.y - wp->cam_pos.y;
+				dz = vertex.z - wp->cam_pos.z;
+
+				/* square, add */
+				dyz2 = SQR(dy) + SQR(dz); /* lump y & z together */
+				dist2 = SQR(dx) + dyz2;
+
+				/** Optical deformation **/
+				if (fx & WARP_FX_DEFORMATION) {
+					/* Calculate v*t and adjust vertex accordingly */
+					x = wp->cam_pos.x + (dx - deform_dist( dx, dyz2, dist2, wp->OD_v_over_C, wp->OD_inv_gamma2 ));
+				}
 			}
-#endif /* DEBUG */
-			len = sqrt01_lut[(int)(len2 * LUT_RES)];
+
+			if (fx & WARP_FX_COLOR) {
+				/* Note: dx and dist2 do NOT get updated!
+				 * alpha_c below is calculated w.r.t. the
+				 * vertex's "actual" position */
+
+				/* Need two angles for the color transforms:
+				 * alpha_n = angle between direction of
+				 * travel and vertex normal;
+				 * alpha_c = angle between direction of
+				 * travel and vertex-to-camera vector */
+				cos_alpha_n = cnormal.x;
+				if (dist2 > 1E-6)
+					cos_alpha_c = - dx / sqrt( dist2 );
+				else
+					cos_alpha_c = 0.0;
+
+				/**** RELATIVISTIC COLOR/INTENSITY TRANSFORMS ****/
+
+				/* (Re)load base RGB color */
+				color.r = obj->color0.r;
+				color.g = obj->color0.g;
+				color.b = obj->color0.b;
+
+				/* Incoming light ray */
+				/* in_ray.r = 1.0; */
+				/* in_ray.g = 1.0; */
+				/* in_ray.b = 1.0; */
+
+				/** Headlight effect (incoming light) **/
+				if (fx & WARP_FX_HEADLIGHT) {
+					k = 1.0 + (wp->HE_v_over_C * cos_alpha_n);
+					inten_ratio = SQR(k) * wp->HE_gamma;
+				}
+				else
+					inten_ratio = 1.0;
+				/* in_ray.r *= inten_ratio; */
+				/* in_ray.g *= inten_ratio; */
+				/* in_ray.b *= inten_ratio; */
+				in_ray.r = inten_ratio;
+				in_ray.g = inten_ratio;
+				in_ray.b = inten_ratio;
+
+				/** Doppler frequency shift (incoming light) **/
+				if (fx & WARP_FX_DOPPLER) {
+					freq_ratio = (1.0 + (wp->DS_v_over_C * cos_alpha_n)) * wp->DS_gamma;
+#if USE_LOOKUP_TABLES
+					doppler_shift_lut( &in_ray, freq_ratio );
 #else
-			len = sqrt( len2 );
-#endif /* not USE_LOOKUP_TABLES */
-			if (len < 1E-6)
-				len = 1.0;
-			normal.x = dx / len;
-			normal.y = dy / len;
-			normal.z = dz / len;
-
-			/* Move object to its "real" x-position */
-			d_vertex_x += vehicle_real_x;
-
-			/** Optical deformation **/
-
-			/* Obtain xyz deltas (camera to vertex) */
-			dx = d_vertex_x - cam_pos->x;
-			dy = vertex.y - cam_pos->y;
-			dz = vertex.z - cam_pos->z;
-
-			/* square, add */
-			dyz2 = SQR(dy) + SQR(dz); /* lump y & z together */
-			dist2 = SQR(dx) + dyz2;
-
-			/* Calculate t and adjust vertex accordingly */
-			t = (dx*OD_v - sqrt( C2*dist2 - dyz2*OD_v2 )) / OD_v2_min_C2;
-			d_vertex_x -= OD_v * t;
-
-			/* done with double-precision math */
-			vertex.x = d_vertex_x;
-
-			/* Note: dx and dist2 do NOT get updated!
-			 * alpha_c below is calculated w.r.t. the
-			 * vertex's "actual" position */
-
-			/* Need two angles for the color transforms:
-			 * alpha_n = angle between direction of
-			 * travel and vertex normal;
-			 * alpha_c = angle between direction of
-			 * travel and vertex-to-camera vector */
-			cos_alpha_n = normal.x;
-			if (dist2 > 1E-6)
-				cos_alpha_c = - dx / sqrt( dist2 );
-			else
-				cos_alpha_c = 0.0;
-
-			/**** RELATIVISTIC COLOR/INTENSITY TRANSFORMS ****/
-
-			/* Incoming light ray */
-			/* in_ray.r = 1.0; */
-			/* in_ray.g = 1.0; */
-			/* in_ray.b = 1.0; */
-
-			/** Doppler frequency shift (incoming light) **/
-			k = 1.0 + (HE_v_over_C * cos_alpha_n);
-			inten_ratio = SQR(k) * HE_gamma;
-			/* in_ray.r *= inten_ratio; */
-			/* in_ray.g *= inten_ratio; */
-			/* in_ray.b *= inten_ratio; */
-			in_ray.r = inten_ratio;
-			in_ray.g = inten_ratio;
-			in_ray.b = inten_ratio;
-
-			/** Headlight effect (incoming light) **/
-			freq_ratio = (1.0 + (DS_v_over_C * cos_alpha_n)) * DS_gamma;
-			doppler_shift( &in_ray, freq_ratio );
-
-			/* Illuminative color interaction */
-			color.r *= SQR(in_ray.r);
-			color.g *= SQR(in_ray.g);
-			color.b *= SQR(in_ray.b);
-
-			/** Doppler frequency shift (outgoing light) **/
-			freq_ratio = (1.0 + (DS_v_over_C * cos_alpha_c)) * DS_gamma;
-			doppler_shift_ref( &color, freq_ratio );
+					doppler_shift( &in_ray, freq_ratio );
+#endif
+				}
+
+				/* Illuminative color interaction */
+				color.r *= SQR(in_ray.r);
+				color.g *= SQR(in_ray.g);
+				color.b *= SQR(in_ray.b);
 
-			/** Headlight effect (outgoing light) **/
-			k = 1.0 + (HE_v_over_C * cos_alpha_c);
-			inten_ratio = SQR(k) * HE_gamma;
-			color.r *= inten_ratio;
-			color.g *= inten_ratio;
-			color.b *= inten_ratio;
-
-			/* If intensity exceeds I(1,1,1),
-			 * rotate normal toward camera */
-			intensity = (color.r * RED_STRENGTH) + (color.g * GREEN_STRENGTH) + (color.b * BLUE_STRENGTH);
-			if (intensity > 1.0) {
-				/* Normal interpolation factor, range [0, 1)
-				 * 0 == unchanged, 1 == pointing toward camera */
+				/** Doppler frequency shift (outgoing light) **/
+				if (fx & WARP_FX_DOPPLER) {
+					freq_ratio = (1.0 + (wp->DS_v_over_C * cos_alpha_c)) * wp->DS_gamma;
 #if USE_LOOKUP_TABLES
-				if (intensity <= 2.0) {
-					i = (int)((intensity - 1.0) * LUT_RES);
-					k = normal_interp_lut1[i];
+					doppler_shift_ref_lut( &color, freq_ratio );
+#else
+					doppler_shift_ref( &color, freq_ratio );
+#endif
 				}
-				else {
-					i = (int)(LUT_RES / (intensity - 1.0));
-					k = normal_interp_lut2[i];
+
+				/** Headlight effect (outgoing light) **/
+				if (fx & WARP_FX_HEADLIGHT) {
+					k = 1.0 + (wp->HE_v_over_C * cos_alpha_c);
+					inten_ratio = SQR(k) * wp->HE_gamma;
+					color.r *= inten_ratio;
+					color.g *= inten_ratio;
+					color.b *= inten_ratio;
 				}
+
+				/* If intensity exceeds I(1,1,1),
+				 * rotate normal toward camera */
+				intensity = (color.r * RED_STRENGTH) + (color.g * GREEN_STRENGTH) + (color.b * BLUE_STRENGTH);
+				if (intensity > 1.0) {
+					/* Normal interpolation factor, range [0, 1)
+					 * 0 == unchanged, 1 == pointing toward camera */
+#if WARP_POLY_APPROX
+					k = interp_factor_poly( intensity - 1.0 );
+#elif USE_LOOKUP_TABLES
+					if (intensity <= 2.0) {
+						i = (int)((intensity - 1.0) * LUT_RES);
+						k = normal_interp_lut1[i];
+					}
+					else {
+						i = (int)(LUT_RES / (intensity - 1.0));
+						k = normal_interp_lut2[i];
+					}
 #else
-				k = DEG(atan( intensity - 1.0 )) / 90.0;
-#endif /* not USE_LOOKUP_TABLES */
-				/* Interpolate between normal vector and
-				 * vertex-to-camera vector */
-				normal.x -= k * (dx + normal.x);
-				normal.y -= k * (dy + normal.y);
-				normal.z -= k * (dz + normal.z);
-				/* Renormalize */
-				len = sqrt( SQR(normal.x) + SQR(normal.y) + SQR(normal.z) );
-				if (len < 1E-6)
-					len = 1.0;
-				normal.x /= len;
-				normal.y /= len;
-				normal.z /= len;
-			}
+					k = DEG(atan( intensity - 1.0 )) / 90.0;
+#endif /* not WARP_POLY_APPROX, USE_LOOKUP_TABLES */
+					/* Interpolate between normal vector and
+					 * vertex-to-camera vector */
+					cnormal.x -= k * (dx + cnormal.x);
+					cnormal.y -= k * (dy + cnormal.y);
+					cnormal.z -= k * (dz + cnormal.z);
+					/* Renormalize */
+					len = sqrt( SQR(cnormal.x) + SQR(cnormal.y) + SQR(cnormal.z) );
+					if (len < 1E-6)
+						len = 1.0;
+					cnormal.x /= len;
+					cnormal.y /= len;
+					cnormal.z /= len;
+				}
 
-			/* Done with relativistic transforms */
+				/* Done with relativistic transforms */
 
-			/* Clamp color components to legal range */
-			color.r = MIN(1.0, color.r);
-			color.g = MIN(1.0, color.g);
-			color.b = MIN(1.0, color.b);
+				/* Clamp color components to legal range */
+				color.r = MIN(1.0, color.r);
+				color.g = MIN(1.0, color.g);
+				color.b = MIN(1.0, color.b);
 
-			/* Lastly, perform display gamma correction if needed */
-			if (dgamma_correct) {
-				color.r = dgamma_lut[(int)(color.r * LUT_RES)];
-				color.g = dgamma_lut[(int)(color.g * LUT_RES)];
-				color.b = dgamma_lut[(int)(color.b * LUT_RES)];
+				/* Lastly, perform display gamma correction if needed */
+				if (wp->dgamma_correct) {
+#if WARP_POLY_APPROX
+					color.r = pow01_poly( color.r, wp->dgamma_exp );
+					color.g = pow01_poly( color.g, wp->dgamma_exp );
+					color.b = pow01_poly( color.b, wp->dgamma_exp );
+#else
+					color.r = wp->dgamma_lut[(int)(color.r * LUT_RES)];
+					color.g = wp->dgamma_lut[(int)(color.g * LUT_RES)];
+					color.b = wp->dgamma_lut[(int)(color.b * LUT_RES)];
+#endif
+				}
 			}
+			else
+				color = base_color;
 
-			pnt = &obj->iarrays[vn];
+			pnt = &outs[c][vn];
 			/* Store processed vertex location */
-			pnt->x = vertex.x;
+			pnt->x = x;
 			pnt->y = vertex.y;
 			pnt->z = vertex.z;
 			/* Store processed vertex normal */
-			pnt->nx = normal.x;
-			pnt->ny = normal.y;
-			pnt->nz = normal.z;
+			pnt->nx = cnormal.x;
+			pnt->ny = cnormal.y;
+			pnt->nz = cnormal.z;
 			/* Store processed vertex color */
 			pnt->r = color.r;
 			pnt->g = color.g;
 			pnt->b = color.b;
 		}
 	}
+}
+
 
-	return 0;
+/* Scalar kernel variants, one per combination of effects. The one with
+ * none at all amounts to copying the vertices and normals (moved to the
+ * vehicle's position) and filling in the base color */
+#define WARP_KERNEL_SCALAR_VARIANT(fx) \
+static void \
+warp_kernel_scalar_##fx( ogl_object *obj, const point *vertices, const point *normals, ogl_point **outs, int v0, int v1, const warp_params *wps, int num_wps ) \
+{ \
+	warp_kernel_scalar_fx( obj, vertices, normals, outs, v0, v1, wps, num_wps, fx ); \
+}
+WARP_KERNEL_SCALAR_VARIANT(0)
+WARP_KERNEL_SCALAR_VARIANT(1)
+WARP_KERNEL_SCALAR_VARIANT(2)
+WARP_KERNEL_SCALAR_VARIANT(3)
+WARP_KERNEL_SCALAR_VARIANT(4)
+WARP_KERNEL_SCALAR_VARIANT(5)
+WARP_KERNEL_SCALAR_VARIANT(6)
+WARP_KERNEL_SCALAR_VARIANT(7)
+WARP_KERNEL_SCALAR_VARIANT(8)
+WARP_KERNEL_SCALAR_VARIANT(9)
+WARP_KERNEL_SCALAR_VARIANT(10)
+WARP_KERNEL_SCALAR_VARIANT(11)
+WARP_KERNEL_SCALAR_VARIANT(12)
+WARP_KERNEL_SCALAR_VARIANT(13)
+WARP_KERNEL_SCALAR_VARIANT(14)
+WARP_KERNEL_SCALAR_VARIANT(15)
+
+/* ...indexed by warp_params.effects */
+static void (* const scalar_kernels[WARP_FX_ALL + 1])( ogl_object *obj, const point *vertices, const point *normals, ogl_point **outs, int v0, int v1, const warp_params *wps, int num_wps ) = {
+	warp_kernel_scalar_0, warp_kernel_scalar_1, warp_kernel_scalar_2, warp_kernel_scalar_3,
+	warp_kernel_scalar_4, warp_kernel_scalar_5, warp_kernel_scalar_6, warp_kernel_scalar_7,
+	warp_kernel_scalar_8, warp_kernel_scalar_9, warp_kernel_scalar_10, warp_kernel_scalar_11,
+	warp_kernel_scalar_12, warp_kernel_scalar_13, warp_kernel_scalar_14, warp_kernel_scalar_15
+};
+
+
+/* Scalar kernel, specialized for the effects in wp->effects */
+static void
+warp_kernel_scalar( ogl_object *obj, ogl_point *out, int v0, int v1, const warp_params *wp )
+{
+	scalar_kernels[wp->effects]( obj, obj->vertices0, obj->normals0, &out, v0, v1, wp, 1 );
 }
 
 
-/* This performs the relativistic geometrical transform, but for a single point,
- * with the camera at the specified location */
-void
-warp_point( point *vertex, point *normal, point *cam_pos )
+/* Same, for several cameras at once (cf. warp_kernel_scalar_fx( )), with
+ * the given effects and source geometry (cf. warp_range( )) */
+static void
+warp_kernel_scalar_multi( ogl_object *obj, const point *vertices, const point *normals, ogl_point **outs, int v0, int v1, const warp_params *wps, int num_wps, int effects )
 {
-	double gamma;
-	double d_vertex_x;
-	double dx,dy,dz;
-	double len;
-	double dyz2, dist2;
-	double v, v2, t;
+	scalar_kernels[effects]( obj, vertices, normals, outs, v0, v1, wps, num_wps );
+}
+
+
+/* Times the scalar and SIMD kernels on the current geometry, and reports
+ * the speedup and largest discrepancy of the latter (for PERFSTATS) */
+static void
+warp_benchmark( const warp_params *wp )
+{
+	warp_job job;
+	ogl_object *obj;
+	ogl_point *ref_pnts;
+	ogl_point *p1, *p2;
+	double t0, scalar_t, simd_t, pool_t;
+	float err, max_geom_err = 0.0, max_color_err = 0.0;
+	int num_vertices = 0;
+	int o, v;
+
+	for (o = 0; o < num_vehicle_objs; o++)
+		num_vertices += vehicle_objs[o]->num_vertices;
+
+	t0 = read_system_clock( );
+	for (o = 0; o < num_vehicle_objs; o++) {
+		obj = vehicle_objs[o];
+		warp_kernel_scalar( obj, obj->iarrays, 0, obj->num_vertices, wp );
+	}
+	scalar_t = read_system_clock( ) - t0;
+	printf( "Warp kernel: scalar %.2f ms (%d vertices, effects:%s%s%s%s%s)\n", 1000.0 * scalar_t, num_vertices,
+		(wp->effects & WARP_FX_CONTRACTION) ? " LC" : "",
+		(wp->effects & WARP_FX_DEFORMATION) ? " OD" : "",
+		(wp->effects & WARP_FX_DOPPLER) ? " DS" : "",
+		(wp->effects & WARP_FX_HEADLIGHT) ? " HE" : "",
+		(wp->effects == 0) ? " none" : "" );
+
+	/* What the specialized kernel saves over the general one */
+	if (wp->effects != WARP_FX_ALL) {
+		t0 = read_system_clock( );
+		for (o = 0; o < num_vehicle_objs; o++) {
+			obj = vehicle_objs[o];
+			scalar_kernels[WARP_FX_ALL]( obj, obj->vertices0, obj->normals0, &obj->iarrays, 0, obj->num_vertices, wp, 1 );
+		}
+		t0 = read_system_clock( ) - t0;
+		printf( "             (all effects: %.2f ms)\n", 1000.0 * t0 );
+	}
+
+	/* As actually run, i.e. across the worker threads */
+	job.wp = wp;
+	job.num_wps = 1;
+	job.objs = vehicle_objs;
+	job.num_objs = num_vehicle_objs;
+	job.out = NULL;
+	job.use_lc_cache = FALSE;
+	job.grads = NULL;
+	job.blocks = NULL;
+	t0 = read_system_clock( );
+	warp_pool_run( vehicle_objs, num_vehicle_objs, warp_range, &job );
+	pool_t = read_system_clock( ) - t0;
+	printf( "             %s on %d threads: %.2f ms\n", use_simd ? "AVX2" : "scalar", warp_pool_get_num_threads( ), 1000.0 * pool_t );
+	printf( "             %d views warped (%d multi-camera passes), %d redrawn as-is, %d shared\n", num_views_warped, num_camera_batches, num_views_cached, num_views_shared );
+	printf( "             contracted geometry: %d rebuilds (%.1f ms), %d reuses\n", num_lc_builds, 1000.0 * lc_build_t, num_lc_reuses );
+	printf( "             while dragging: %d views extrapolated, %d warped exactly past tolerance\n", num_views_extrapolated, num_extrapolation_limits );
+	printf( "             pipeline depth %d: %d views warped ahead, %d shown out of date, %.1f ms waited\n", pipeline_depth, num_views_ahead, num_views_stale, 1000.0 * ahead_wait_t );
+	printf( "             frustum culling: %.1f%% of vertex blocks warped (%.1f%% late), %.1f%% of meshlets drawn\n", 100.0 * num_blocks_warped / MAX(1.0, num_blocks_total), 100.0 * num_blocks_late / MAX(1.0, num_blocks_total), 100.0 * num_meshlets_drawn / MAX(1.0, num_meshlets_total) );
+	deform_precision_check( );
+	poly_precision_check( );
+#if USE_LOOKUP_TABLES
+	doppler_benchmark( );
+#endif
+
+#ifdef WARP_SIMD_X86
+	if (!warp_simd_supported( )) {
+		printf( "             (no AVX2 support, using scalar kernel)\n" );
+		return;
+	}
+
+	t0 = read_system_clock( );
+	for (o = 0; o < num_vehicle_objs; o++) {
+		obj = vehicle_objs[o];
+		if (obj->soa0 == NULL)
+			update_ogl_object_soa( obj );
+		warp_kernel_avx2( obj, obj->iarrays, 0, obj->num_vertices, wp );
+	}
+	simd_t = read_system_clock( ) - t0;
+
+	/* Compare against scalar results */
+	for (o = 0; o < num_vehicle_objs; o++) {
+		obj = vehicle_objs[o];
+		ref_pnts = xmalloc( obj->num_vertices * sizeof(ogl_point) );
+		warp_kernel_scalar( obj, ref_pnts, 0, obj->num_vertices, wp );
+		for (v = 0; v < obj->num_vertices; v++) {
+			p1 = &ref_pnts[v];
+			p2 = &obj->iarrays[v];
+			err = ABS(p1->x - p2->x) + ABS(p1->y - p2->y) + ABS(p1->z - p2->z);
+			max_geom_err = MAX(err, max_geom_err);
+			err = MAX(ABS(p1->r - p2->r), MAX(ABS(p1->g - p2->g), ABS(p1->b - p2->b)));
+			max_color_err = MAX(err, max_color_err);
+		}
+		xfree( ref_pnts );
+	}
+
+	printf( "             AVX2 %.2f ms (%.2fx speedup)\n", 1000.0 * simd_t, scalar_t / MAX(1E-9, simd_t) );
+	printf( "             max. deviation: %.2g m, %.2g RGB\n", max_geom_err, max_color_err );
+#else
+	printf( "             (SIMD kernel not compiled in)\n" );
+#endif /* not WARP_SIMD_X86 */
+}
+
+
+/* Times warping for a few velocities up to the current one, and for a few
+ * camera positions around the current one, in a single job against doing
+ * each separately (for PERFSTATS) */
+static void
+batch_benchmark( const warp_context *ctx, point *cam_pos )
+{
+	const int num_batch = 4;
+	warp_context vctx;
+	warp_params wps[4];
+	ogl_point **outs;
+	double velocities[4];
+	double t0, batch_t, single_t;
+	int i, o;
+
+	outs = xmalloc( num_batch * num_vehicle_objs * sizeof(ogl_point *) );
+	for (i = 0; i < num_batch; i++) {
+		velocities[i] = ctx->velocity * (i + 1) / num_batch;
+		for (o = 0; o < num_vehicle_objs; o++) {
+			outs[i * num_vehicle_objs + o] = xmalloc( vehicle_objs[o]->num_vertices * sizeof(ogl_point) );
+			/* (keep page faults out of the timings) */
+			memset( outs[i * num_vehicle_objs + o], 0, vehicle_objs[o]->num_vertices * sizeof(ogl_point) );
+		}
+	}
+	vctx = *ctx;
+
+	t0 = read_system_clock( );
+	for (i = 0; i < num_batch; i++) {
+		vctx.velocity = velocities[i];
+		warp_run( &vctx, vehicle_objs, num_vehicle_objs, cam_pos, &outs[i * num_vehicle_objs] );
+	}
+	single_t = read_system_clock( ) - t0;
+
+	t0 = read_system_clock( );
+	warp_run_velocities( &vctx, vehicle_objs, num_vehicle_objs, cam_pos, num_batch, velocities, NULL, outs );
+	batch_t = read_system_clock( ) - t0;
+
+	printf( "Velocity batch: %d velocities in %.2f ms (one at a time: %.2f ms)\n", num_batch, 1000.0 * batch_t, 1000.0 * single_t );
+
+	/* Cameras spread out sideways */
+	vctx = *ctx;
+	calc_warp_params( &vctx, cam_pos, &wps[0] );
+	for (i = 1; i < num_batch; i++) {
+		wps[i] = wps[0];
+		wps[i].cam_pos.y += 0.25 * i * vehicle_extents.avg;
+	}
+
+	t0 = read_system_clock( );
+	for (i = 0; i < num_batch; i++)
+		run_warp( &wps[i], 1, vehicle_objs, num_vehicle_objs, &outs[i * num_vehicle_objs], NULL, NULL, FALSE );
+	single_t = read_system_clock( ) - t0;
 
-	gamma = lorentz_factor( velocity );
+	t0 = read_system_clock( );
+	run_warp( wps, num_batch, vehicle_objs, num_vehicle_objs, outs, NULL, NULL, FALSE );
+	batch_t = read_system_clock( ) - t0;
 
-	/* Perform calculations in double precision */
-	d_vertex_x = vertex->x;
+	printf( "Camera batch: %d cameras in %.2f ms (one at a time: %.2f ms)\n", num_batch, 1000.0 * batch_t, 1000.0 * single_t );
+
+	for (i = 0; i < num_batch * num_vehicle_objs; i++)
+		xfree( outs[i] );
+	xfree( outs );
+}
+
+
+/* Sweeps velocity (MIN_VELOCITY to MAX_VELOCITY, evenly in log(C - v))
+ * and camera distance (vehicle size to 1E4 times that, from all angles),
+ * comparing deform_dist( ) against the textbook solve in long double.
+ * Errors are of the deformed vertex's direction as seen from the camera,
+ * i.e. relative to its distance. Passes if they are all within
+ * WARP_DEFORM_MAX_ERROR */
+static void
+deform_precision_check( void )
+{
+	const int num_velocities = 64, num_distances = 9, num_angles = 64;
+	long double ld_v, ld_t, ld_dx;
+	double v, beta, inv_gamma2;
+	double d_t, d_dx;
+	double size, dist, theta;
+	double len, err, max_err = 0.0, max_d_err = 0.0;
+	float dx, dyz2, dist2;
+	float f_dx, worst_v = 0.0;
+	int i, j, k;
+
+	size = MAX(1.0, vehicle_extents.avg);
+	for (i = 0; i < num_velocities; i++) {
+		v = C - pow( C - MIN_VELOCITY, 1.0 - (double)i / (num_velocities - 1) );
+		beta = v / C;
+		inv_gamma2 = (1.0 - beta) * (1.0 + beta);
+		for (j = 0; j < num_distances; j++) {
+			dist = size * pow( 10.0, 0.5 * j );
+			for (k = 0; k < num_angles; k++) {
+				theta = PI * (k + 0.5) / num_angles;
+				dx = dist * cos( theta );
+				dyz2 = SQR(dist * sin( theta ));
+				dist2 = SQR(dx) + dyz2;
+
+				/* Reference, and the double precision solve
+				 * as was (each with dist2 in its precision,
+				 * which the textbook solve is sensitive to) */
+				ld_v = v;
+				ld_t = (dx * ld_v - sqrtl( C2 * ((long double)dx * dx + dyz2) - dyz2 * ld_v * ld_v )) / (ld_v * ld_v - C2);
+				ld_dx = dx - ld_v * ld_t;
+				d_t = (dx * v - sqrt( C2 * ((double)dx * dx + dyz2) - dyz2 * SQR(v) )) / (SQR(v) - C2);
+				d_dx = dx - v * d_t;
+				/* (with the constants rounded, as the kernels
+				 * get them) */
+				f_dx = dx - deform_dist( dx, dyz2, dist2, (float)beta, (float)inv_gamma2 );
+
+				len = sqrt( SQR((double)ld_dx) + dyz2 );
+				err = ABS((double)(f_dx - ld_dx)) / len;
+				if (err > max_err) {
+					max_err = err;
+					worst_v = v;
+				}
+				err = ABS((double)(d_dx - ld_dx)) / len;
+				max_d_err = MAX(max_d_err, err);
+			}
+		}
+	}
 
-	/** Lorentz contraction **/
-	d_vertex_x /= gamma;
+	printf( "Deformation solve (float): max. error %.2g rad (at v = c - %.3g m/s), textbook in double: %.2g rad\n", max_err, C - worst_v, max_d_err );
+	printf( "             %s (bound %.2g rad)\n", (max_err <= WARP_DEFORM_MAX_ERROR) ? "PASS" : "FAIL", WARP_DEFORM_MAX_ERROR );
+}
 
-	/* Adjust normal, if we have a normal to adjust */
-	if (normal != NULL) {
-		dx = normal->x;
-		dy = normal->y / gamma;
-		dz = normal->z / gamma;
 
-		/* Renormalize */
-		len = sqrt( SQR(dx) + SQR(dy) + SQR(dz) );
-		if (len < 1E-6)
-			len = 1.0;
-		normal->x = dx / len;
-		normal->y = dy / len;
-		normal->z = dz / len;
+/* Compares the polynomial approximations (WARP_POLY_APPROX) and the look-up
+ * tables they stand in for against the real thing, and prints the worst
+ * (absolute) errors of each: normal interpolation factor, display gamma
+ * correction (with the current gamma), and square root for renormalizing
+ * (which the polynomial kernels take in full, or via rsqrt in AVX2) */
+static void
+poly_precision_check( void )
+{
+	const int num_samples = 1 << 20;
+	double s, x, exact;
+	double atan_err = 0.0, atan_lut_err = 0.0;
+	double pow_err = 0.0, pow_lut_err = 0.0;
+	double sqrt_lut_err = 0.0;
+	float k;
+	int i;
+
+	for (i = 0; i < num_samples; i++) {
+		/* Intensity excess, over (0, 64] */
+		s = 64.0 * (i + 1) / num_samples;
+		exact = DEG(atan( s )) / 90.0;
+		atan_err = MAX(atan_err, ABS(interp_factor_poly( s ) - exact));
+		if (s <= 1.0)
+			k = normal_interp_lut1[(int)(s * LUT_RES)];
+		else
+			k = normal_interp_lut2[(int)(LUT_RES / s)];
+		atan_lut_err = MAX(atan_lut_err, ABS(k - exact));
+
+		/* Color component, over [0, 1) */
+		x = (double)i / num_samples;
+		exact = pow( x, ui_ctx.dgamma_exp );
+		pow_err = MAX(pow_err, ABS(pow01_poly( x, ui_ctx.dgamma_exp ) - exact));
+		pow_lut_err = MAX(pow_lut_err, ABS(dgamma_lut[(int)(x * LUT_RES)] - exact));
+#if USE_LOOKUP_TABLES
+		sqrt_lut_err = MAX(sqrt_lut_err, ABS(sqrt01_lut[(int)(x * LUT_RES)] - sqrt( x )));
+#endif
 	}
 
-	/* Move object to its "real" x-position */
-	d_vertex_x += velocity * cur_time_t;
+	printf( "Polynomials (%s): max. error %.2g (normal interp.), %.2g (gamma %.2f)\n", WARP_POLY_APPROX ? "in use" : "not in use", atan_err, pow_err, 1.0 / ui_ctx.dgamma_exp );
+	printf( "             tables: %.2g, %.2g", atan_lut_err, pow_lut_err );
+#if USE_LOOKUP_TABLES
+	printf( " (and sqrt: %.2g)", sqrt_lut_err );
+#endif
+	printf( "\n" );
+}
+
+
+/* This performs the relativistic geometrical transform, but for a single point,
+ * with the camera at the specified location */
+void
+warp_point( point *vertex, point *normal, point *cam_pos )
+{
+	warp_points( vertex, normal, 1, cam_pos );
+}
+
 
-	dx = d_vertex_x - cam_pos->x;
-	dy = vertex->y - cam_pos->y;
-	dz = vertex->z - cam_pos->z;
+/* Same as warp_point( ), for a whole array of points (and of their normals,
+ * if normals is not NULL). The velocity-dependent constants are worked out
+ * once per call rather than once per point (deform_dist( ) still branches
+ * on which side of the camera each point is) */
+void
+warp_points( point *vertices, point *normals, int num_points, point *cam_pos )
+{
+	double inv_gamma;
+	double real_x;
+	double beta, inv_gamma2;
+	double len;
+	float dx,dy,dz;
+	float dyz2, dist2;
+	int i;
+
+	inv_gamma = 1.0 / lorentz_factor( velocity );
+	real_x = velocity * cur_time_t;
+	beta = velocity / C;
+	inv_gamma2 = (1.0 - beta) * (1.0 + beta);
+
+	/* Adjust normals, if we have normals to adjust */
+	if (normals != NULL) {
+		for (i = 0; i < num_points; i++) {
+			dx = normals[i].x;
+			dy = normals[i].y * inv_gamma;
+			dz = normals[i].z * inv_gamma;
+
+			/* Renormalize */
+			len = sqrt( SQR(dx) + SQR(dy) + SQR(dz) );
+			len = (len < 1E-6) ? 1.0 : len;
+			normals[i].x = dx / len;
+			normals[i].y = dy / len;
+			normals[i].z = dz / len;
+		}
+	}
 
-	dyz2 = SQR(dy) + SQR(dz);
-	dist2 = SQR(dx) + SQR(dy) + SQR(dz);
-	v = velocity;
-	v2 = SQR(velocity);
+	for (i = 0; i < num_points; i++) {
+		/* Lorentz contraction, then move object to
+		 * its "real" x-position (relative to the camera) */
+		dx = vertices[i].x * inv_gamma + (real_x - cam_pos->x);
+		dy = vertices[i].y - cam_pos->y;
+		dz = vertices[i].z - cam_pos->z;
 
-	/* Calculate t and adjust vertex accordingly */
-	t = (dx*v - sqrt( C2*dist2 - dyz2*v2 )) / (v2 - C2);
-	d_vertex_x -= velocity * t;
+		dyz2 = SQR(dy) + SQR(dz);
+		dist2 = SQR(dx) + dyz2;
 
-	vertex->x = d_vertex_x;
+		/* Calculate v*t and adjust vertex accordingly */
+		vertices[i].x = cam_pos->x + (dx - deform_dist( dx, dyz2, dist2, beta, inv_gamma2 ));
+	}
 }
 
 
@@ -524,6 +2390,212 @@ doppler_shift_ref( rgb_color *color, float freq_ratio )
 }
 
 
+#if USE_LOOKUP_TABLES
+/* Fills in the Doppler shift tables. Both shift functions are linear in
+ * the original color, so the columns of a reflected-light matrix are
+ * simply the shifted primaries */
+static void
+init_doppler_luts( void )
+{
+	rgb_color color;
+	double u;
+	float freq_ratio;
+	int i, j;
+
+	for (i = 0; i <= LUT_RES; i++) {
+		/* Inverse of the mapping in doppler_lut_pos( ) */
+		u = (2.0 * DOPPLER_LUT_OCTAVES * i) / LUT_RES - DOPPLER_LUT_OCTAVES;
+		freq_ratio = ldexp( 1.0 + (u - floor( u )), (int)floor( u ) );
+
+		/* Incoming (white) light */
+		color.r = 1.0;
+		color.g = 1.0;
+		color.b = 1.0;
+		doppler_shift( &color, freq_ratio );
+		doppler_in_lut[i][0] = color.r;
+		doppler_in_lut[i][1] = color.g;
+		doppler_in_lut[i][2] = color.b;
+
+		/* Reflected light */
+		for (j = 0; j < 3; j++) {
+			color.r = (j == 0) ? 1.0 : 0.0;
+			color.g = (j == 1) ? 1.0 : 0.0;
+			color.b = (j == 2) ? 1.0 : 0.0;
+			doppler_shift_ref( &color, freq_ratio );
+			doppler_ref_lut[i][j] = color.r;
+			doppler_ref_lut[i][3 + j] = color.g;
+			doppler_ref_lut[i][6 + j] = color.b;
+		}
+	}
+}
+
+
+/* Returns the position of a frequency ratio in the Doppler shift tables,
+ * as the index of the lower of two entries to interpolate between plus
+ * the interpolation factor (via frac), or -1 if the tables don't reach
+ * that far. Entries are spaced evenly in
+ * u = e + m - 1, where freq_ratio = m * 2^e (1 <= m < 2). This is
+ * log2( freq_ratio ) at powers of two and linear in between, and comes
+ * straight out of the bits of an IEEE float */
+static int
+doppler_lut_pos( float freq_ratio, float *frac )
+{
+	union { float f; unsigned int i; } bits;
+	float x;
+	int e, i;
+
+	bits.f = freq_ratio;
+	e = (int)((bits.i >> 23) & 0xFF) - 127;
+	bits.i = (bits.i & 0x007FFFFF) | 0x3F800000; /* m */
+	x = ((float)e + bits.f + (float)(DOPPLER_LUT_OCTAVES - 1)) * (float)(LUT_RES / (2.0 * DOPPLER_LUT_OCTAVES));
+	if ((x < 0.0) || (x >= (float)LUT_RES))
+		return -1;
+	i = (int)x;
+	*frac = x - (float)i;
+
+	return i;
+}
+
+
+/* Table-driven doppler_shift( ), for white light only (i.e. color->r ==
+ * color->g == color->b, which is all the warp kernel ever passes it).
+ * Beyond the tables (where the shift keeps scaling with the frequency
+ * ratio), it hands over to doppler_shift( ) */
+static void
+doppler_shift_lut( rgb_color *color, float freq_ratio )
+{
+	const float *c0, *c1;
+	float intensity;
+	float t;
+	int i;
+
+	i = doppler_lut_pos( freq_ratio, &t );
+	if (i < 0) {
+		doppler_shift( color, freq_ratio );
+		return;
+	}
+	c0 = doppler_in_lut[i];
+	c1 = doppler_in_lut[i + 1];
+	intensity = color->r;
+	color->r = intensity * (c0[0] + t * (c1[0] - c0[0]));
+	color->g = intensity * (c0[1] + t * (c1[1] - c0[1]));
+	color->b = intensity * (c0[2] + t * (c1[2] - c0[2]));
+}
+
+
+/* Table-driven doppler_shift_ref( ): matrix-vector products with two
+ * adjacent table entries, interpolated (or doppler_shift_ref( ) itself,
+ * beyond the tables) */
+static void
+doppler_shift_ref_lut( rgb_color *color, float freq_ratio )
+{
+	const float *m0, *m1;
+	float r0,g0,b0;
+	float r1,g1,b1;
+	float r2,g2,b2;
+	float t;
+	int i;
+
+	i = doppler_lut_pos( freq_ratio, &t );
+	if (i < 0) {
+		doppler_shift_ref( color, freq_ratio );
+		return;
+	}
+	m0 = doppler_ref_lut[i];
+	m1 = doppler_ref_lut[i + 1];
+
+	r0 = color->r;
+	g0 = color->g;
+	b0 = color->b;
+	r1 = (m0[0] * r0) + (m0[1] * g0) + (m0[2] * b0);
+	g1 = (m0[3] * r0) + (m0[4] * g0) + (m0[5] * b0);
+	b1 = (m0[6] * r0) + (m0[7] * g0) + (m0[8] * b0);
+	r2 = (m1[0] * r0) + (m1[1] * g0) + (m1[2] * b0);
+	g2 = (m1[3] * r0) + (m1[4] * g0) + (m1[5] * b0);
+	b2 = (m1[6] * r0) + (m1[7] * g0) + (m1[8] * b0);
+	color->r = r1 + t * (r2 - r1);
+	color->g = g1 + t * (g2 - g1);
+	color->b = b1 + t * (b2 - b1);
+}
+
+
+/* Compares the table-driven Doppler shift functions against the originals,
+ * for speed and accuracy (for PERFSTATS) */
+static void
+doppler_benchmark( void )
+{
+	const int num_samples = 65536;
+	rgb_color *samples;
+	rgb_color *ref_out, *lut_out;
+	float *freq_ratios;
+	double max_octaves;
+	double t0, ref_t, lut_t;
+	float err, max_err = 0.0;
+	unsigned int seed = 1;
+	int i;
+
+	samples = xmalloc( num_samples * sizeof(rgb_color) );
+	ref_out = xmalloc( 2 * num_samples * sizeof(rgb_color) );
+	lut_out = xmalloc( 2 * num_samples * sizeof(rgb_color) );
+	freq_ratios = xmalloc( num_samples * sizeof(float) );
+
+	/* Random colors, and frequency ratios spread evenly (in log space)
+	 * over all that the velocity can come to, either way */
+	max_octaves = 0.5 * log( (C + MAX_VELOCITY) / (C - MAX_VELOCITY) ) / log( 2.0 );
+	for (i = 0; i < num_samples; i++) {
+		seed = seed * 1103515245 + 12345;
+		samples[i].r = (float)((seed >> 8) & 0xFFFF) / 65535.0;
+		seed = seed * 1103515245 + 12345;
+		samples[i].g = (float)((seed >> 8) & 0xFFFF) / 65535.0;
+		seed = seed * 1103515245 + 12345;
+		samples[i].b = (float)((seed >> 8) & 0xFFFF) / 65535.0;
+		seed = seed * 1103515245 + 12345;
+		freq_ratios[i] = pow( 2.0, max_octaves * (2.0 * (float)((seed >> 8) & 0xFFFF) / 65535.0 - 1.0) );
+	}
+
+	/* (keep page faults out of the timings) */
+	memset( ref_out, 0, 2 * num_samples * sizeof(rgb_color) );
+	memset( lut_out, 0, 2 * num_samples * sizeof(rgb_color) );
+
+	t0 = read_system_clock( );
+	for (i = 0; i < num_samples; i++) {
+		ref_out[2 * i].r = samples[i].r;
+		ref_out[2 * i].g = samples[i].r;
+		ref_out[2 * i].b = samples[i].r;
+		doppler_shift( &ref_out[2 * i], freq_ratios[i] );
+		ref_out[2 * i + 1] = samples[i];
+		doppler_shift_ref( &ref_out[2 * i + 1], freq_ratios[i] );
+	}
+	ref_t = read_system_clock( ) - t0;
+
+	t0 = read_system_clock( );
+	for (i = 0; i < num_samples; i++) {
+		lut_out[2 * i].r = samples[i].r;
+		lut_out[2 * i].g = samples[i].r;
+		lut_out[2 * i].b = samples[i].r;
+		doppler_shift_lut( &lut_out[2 * i], freq_ratios[i] );
+		lut_out[2 * i + 1] = samples[i];
+		doppler_shift_ref_lut( &lut_out[2 * i + 1], freq_ratios[i] );
+	}
+	lut_t = read_system_clock( ) - t0;
+
+	/* (relative to the result, for the far ends' big intensities) */
+	for (i = 0; i < 2 * num_samples; i++) {
+		err = MAX(ABS(ref_out[i].r - lut_out[i].r), MAX(ABS(ref_out[i].g - lut_out[i].g), ABS(ref_out[i].b - lut_out[i].b)));
+		err /= MAX(1.0, MAX(ABS(ref_out[i].r), MAX(ABS(ref_out[i].g), ABS(ref_out[i].b))));
+		max_err = MAX(err, max_err);
+	}
+
+	printf( "Doppler LUT: %.1f ns/vertex (ladder: %.1f ns), max. error %.2g\n", 1E9 * lut_t / num_samples, 1E9 * ref_t / num_samples, max_err );
+
+	xfree( samples );
+	xfree( ref_out );
+	xfree( lut_out );
+	xfree( freq_ratios );
+}
+#endif /* USE_LOOKUP_TABLES */
+
+
 /* This next function takes care of determining simulation time (cur_time_t).
  * If the vehicle is not being animated, warp_time( ) sets time t to keep the
  * image centered on the origin. If animation is active, time t is returned as
@@ -544,14 +2616,19 @@ warp_time( float x0, float x1, double value, int message )
 	float loop_time = 0.0;
 
 	/* Preliminary */
-	if (message == WARP_BEGIN_ANIM) {
+	if ((message == WARP_BEGIN_ANIM) || (message == WARP_SET_ANIM)) {
 		anim_x0 = x0;
 		anim_x1 = x1;
 		/* Make SURE these two are not still in transition queue
 		 * (i.e. if user hits Begin suddenly after Stop) */
 		break_transition( &anim_x0 );
 		break_transition( &anim_x1 );
-		loop_time = value;
+		if (message == WARP_BEGIN_ANIM)
+			loop_time = value;
+		else {
+			break_transition( &anim_percent );
+			anim_percent = value;
+		}
 		v = velocity;
 	}
 	else
@@ -581,6 +2658,11 @@ warp_time( float x0, float x1, double value, int message )
 	case WARP_UPDATE_TIME_T:
 		break;
 
+	case WARP_SET_ANIM:
+		/* Animation frame given outright (value == percent between
+		 * x0 and x1), with no clock involved */
+		break;
+
 	case WARP_BEGIN_ANIM:
 		/* Set anim_percent so object doesn't initially JUMP to x0 */
 		anim_percent = (cur_time_t - anim_t0) / (anim_t1 - anim_t0);
@@ -0,0 +1,389 @@
+/* warp_pool.c */
+
+/* Worker thread pool for the warp engine */
+
+/*
+ *  ``The contents of this file are subject to the Mozilla Public License
+ *  Version 1.0 (the "License"); you may not use this file except in
+ *  compliance with the License. You may obtain a copy of the License at
+ *  http://www.mozilla.org/MPL/
+ *
+ *  Software distributed under the License is distributed on an "AS IS"
+ *  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+ *  License for the specific language governing rights and limitations
+ *  under the License.
+ *
+ *  The Original Code is the "Light Speed!" relativistic simulator.
+ *
+ *  The Initial Developer of the Original Code is Daniel Richard G.
+ *  Portions created by the Initial Developer are Copyright (C) 1999
+ *  Daniel Richard G. <skunk@mit.edu> All Rights Reserved.
+ *
+ *  Contributor(s): ______________________________________.''
+ */
+
+
+#include "lightspeed.h"
+
+#ifdef WITH_THREADED_WARP
+#include <pthread.h>
+#include <unistd.h>
+
+
+/* One vertex range of one object */
+typedef struct {
+	int obj_id;
+	int v0, v1;
+} warp_chunk;
+
+/* Each thread owns a contiguous run of chunk indices. The owner takes
+ * chunks from the head, idle threads steal them from the tail */
+typedef struct {
+	pthread_mutex_t lock;
+	int head, tail;
+} chunk_queue;
+
+
+/* Pool state. The calling thread acts as worker 0, so only
+ * (num_threads - 1) threads are actually spawned */
+static int num_threads = 1;
+static pthread_t *threads = NULL;
+static chunk_queue *queues = NULL;
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER;
+static int generation = 0;
+static int chunks_left = 0;
+static int shutdown_pool = FALSE;
+/* Held while the pool is busy with a job (or being rebuilt) */
+static pthread_mutex_t run_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Current job */
+static warp_chunk *chunks = NULL;
+static int num_chunks = 0;
+static int max_chunks = 0;
+static void (*job_func)( int obj_id, int v0, int v1, void *data );
+static void *job_data;
+
+/* Background job (see warp_pool_run_async( )), run by a thread of its own
+ * which in turn farms it out to the pool */
+static pthread_t async_thread;
+static int async_started = FALSE;
+static pthread_mutex_t async_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t async_cond = PTHREAD_COND_INITIALIZER;
+static int async_busy = FALSE;
+static ogl_object **async_objs;
+static int async_num_objs;
+static void (*async_func)( int obj_id, int v0, int v1, void *data );
+static void *async_data;
+
+
+/* Returns the index of the next chunk for thread "id" to process, taking
+ * one from another thread if need be, or -1 if there is nothing left */
+static int
+take_chunk( int id )
+{
+	chunk_queue *q;
+	int c = -1;
+	int i;
+
+	q = &queues[id];
+	pthread_mutex_lock( &q->lock );
+	if (q->head < q->tail)
+		c = q->head++;
+	pthread_mutex_unlock( &q->lock );
+	if (c >= 0)
+		return c;
+
+	/* Own queue is empty, go steal */
+	for (i = 1; i < num_threads; i++) {
+		q = &queues[(id + i) % num_threads];
+		pthread_mutex_lock( &q->lock );
+		if (q->head < q->tail)
+			c = --q->tail;
+		pthread_mutex_unlock( &q->lock );
+		if (c >= 0)
+			return c;
+	}
+
+	return -1;
+}
+
+
+/* Process chunks until none are left */
+static void
+do_work( int id )
+{
+	warp_chunk *chunk;
+	int num_done = 0;
+	int c;
+
+	while ((c = take_chunk( id )) >= 0) {
+		chunk = &chunks[c];
+		job_func( chunk->obj_id, chunk->v0, chunk->v1, job_data );
+		++num_done;
+	}
+
+	if (num_done == 0)
+		return;
+	pthread_mutex_lock( &pool_lock );
+	chunks_left -= num_done;
+	if (chunks_left == 0)
+		pthread_cond_signal( &done_cond );
+	pthread_mutex_unlock( &pool_lock );
+}
+
+
+/* Worker thread main loop */
+static void *
+worker( void *arg )
+{
+	int id = (int)(long)arg;
+	int my_generation = 0;
+
+	for (;;) {
+		pthread_mutex_lock( &pool_lock );
+		while ((generation == my_generation) && !shutdown_pool)
+			pthread_cond_wait( &work_cond, &pool_lock );
+		if (shutdown_pool) {
+			pthread_mutex_unlock( &pool_lock );
+			return NULL;
+		}
+		my_generation = generation;
+		pthread_mutex_unlock( &pool_lock );
+
+		do_work( id );
+	}
+}
+
+
+/* Background job thread main loop */
+static void *
+async_worker( void *arg )
+{
+	pthread_mutex_lock( &async_lock );
+	for (;;) {
+		while (!async_busy)
+			pthread_cond_wait( &async_cond, &async_lock );
+		pthread_mutex_unlock( &async_lock );
+
+		warp_pool_run( async_objs, async_num_objs, async_func, async_data );
+
+		pthread_mutex_lock( &async_lock );
+		async_busy = FALSE;
+		pthread_cond_broadcast( &async_cond );
+	}
+
+	return NULL;
+}
+
+
+/* Stops and reaps all worker threads */
+static void
+stop_workers( void )
+{
+	int i;
+
+	if (threads == NULL)
+		return;
+
+	pthread_mutex_lock( &pool_lock );
+	shutdown_pool = TRUE;
+	pthread_cond_broadcast( &work_cond );
+	pthread_mutex_unlock( &pool_lock );
+	for (i = 1; i < num_threads; i++)
+		pthread_join( threads[i], NULL );
+
+	for (i = 0; i < num_threads; i++)
+		pthread_mutex_destroy( &queues[i].lock );
+	xfree( threads );
+	xfree( queues );
+	threads = NULL;
+	queues = NULL;
+	shutdown_pool = FALSE;
+	generation = 0;
+}
+#endif /* WITH_THREADED_WARP */
+
+
+/* (Re)creates the pool with the given number of threads, including the
+ * calling one. 0 means one thread per online CPU */
+void
+warp_pool_init( int n )
+{
+#ifdef WITH_THREADED_WARP
+	int i, j;
+
+	if (n <= 0)
+		n = sysconf( _SC_NPROCESSORS_ONLN );
+	n = CLAMP(n, 1, MAX_WARP_THREADS);
+
+	pthread_mutex_lock( &run_lock );
+	stop_workers( );
+	num_threads = n;
+	if (num_threads == 1) {
+		pthread_mutex_unlock( &run_lock );
+		return;
+	}
+
+	threads = xmalloc( num_threads * sizeof(pthread_t) );
+	queues = xmalloc( num_threads * sizeof(chunk_queue) );
+	for (i = 0; i < num_threads; i++) {
+		pthread_mutex_init( &queues[i].lock, NULL );
+		queues[i].head = 0;
+		queues[i].tail = 0;
+	}
+	for (i = 1; i < num_threads; i++) {
+		if (pthread_create( &threads[i], NULL, worker, (void *)(long)i ) != 0) {
+			/* Make do with what we've got */
+			printf( "warp_pool_init( ): could only start %d threads\n", i );
+			fflush( stdout );
+			pthread_mutex_lock( &pool_lock );
+			num_threads = i;
+			pthread_mutex_unlock( &pool_lock );
+			/* (stop_workers( ) only sees the queues in use) */
+			for (j = i; j < n; j++)
+				pthread_mutex_destroy( &queues[j].lock );
+			break;
+		}
+	}
+	pthread_mutex_unlock( &run_lock );
+#endif /* WITH_THREADED_WARP */
+}
+
+
+/* Number of threads the warp engine is running on */
+int
+warp_pool_get_num_threads( void )
+{
+#ifdef WITH_THREADED_WARP
+	return num_threads;
+#else
+	return 1;
+#endif
+}
+
+
+/* Calls func( o, v0, v1, data ) over the full vertex range of each of
+ * the given objects (o being the index into objs), splitting it up across
+ * the pool. Returns once all ranges have been processed. May be called from
+ * several threads at once; whoever finds the pool busy does its job alone */
+void
+warp_pool_run( ogl_object **objs, int num_objs, void (*func)( int obj_id, int v0, int v1, void *data ), void *data )
+{
+	int o;
+#ifdef WITH_THREADED_WARP
+	ogl_object *obj;
+	int use_pool;
+	int c0, c1;
+	int i, v;
+
+	/* Only one job at a time gets the pool, any others are done
+	 * on the calling thread alone */
+	use_pool = (pthread_mutex_trylock( &run_lock ) == 0);
+	if (use_pool && (num_threads == 1)) {
+		pthread_mutex_unlock( &run_lock );
+		use_pool = FALSE;
+	}
+	if (use_pool) {
+		/* Cut vertex ranges into chunks */
+		num_chunks = 0;
+		for (o = 0; o < num_objs; o++) {
+			obj = objs[o];
+			for (v = 0; v < obj->num_vertices; v += WARP_CHUNK_SIZE) {
+				if (num_chunks == max_chunks) {
+					max_chunks = MAX(64, 2 * max_chunks);
+					chunks = xrealloc( chunks, max_chunks * sizeof(warp_chunk) );
+				}
+				chunks[num_chunks].obj_id = o;
+				chunks[num_chunks].v0 = v;
+				chunks[num_chunks].v1 = MIN(v + WARP_CHUNK_SIZE, obj->num_vertices);
+				++num_chunks;
+			}
+		}
+		if (num_chunks == 0) {
+			pthread_mutex_unlock( &run_lock );
+			return;
+		}
+
+		/* Deal them out, and wake up the workers */
+		pthread_mutex_lock( &pool_lock );
+		job_func = func;
+		job_data = data;
+		for (i = 0; i < num_threads; i++) {
+			c0 = (i * num_chunks) / num_threads;
+			c1 = ((i + 1) * num_chunks) / num_threads;
+			pthread_mutex_lock( &queues[i].lock );
+			queues[i].head = c0;
+			queues[i].tail = c1;
+			pthread_mutex_unlock( &queues[i].lock );
+		}
+		chunks_left = num_chunks;
+		++generation;
+		pthread_cond_broadcast( &work_cond );
+		pthread_mutex_unlock( &pool_lock );
+
+		/* Pitch in, then wait for stragglers */
+		do_work( 0 );
+		pthread_mutex_lock( &pool_lock );
+		while (chunks_left > 0)
+			pthread_cond_wait( &done_cond, &pool_lock );
+		pthread_mutex_unlock( &pool_lock );
+		pthread_mutex_unlock( &run_lock );
+		return;
+	}
+#endif /* WITH_THREADED_WARP */
+
+	/* Single-threaded */
+	for (o = 0; o < num_objs; o++)
+		func( o, 0, objs[o]->num_vertices, data );
+}
+
+
+
+/* Same as warp_pool_run( ), but returns right away, leaving the job to run
+ * in the background. Only one such job can be under way at a time (this
+ * waits for the previous one, if need be), and the caller must not touch
+ * anything it uses before warp_pool_wait( ) */
+void
+warp_pool_run_async( ogl_object **objs, int num_objs, void (*func)( int obj_id, int v0, int v1, void *data ), void *data )
+{
+#ifdef WITH_THREADED_WARP
+	pthread_mutex_lock( &async_lock );
+	if (!async_started) {
+		if (pthread_create( &async_thread, NULL, async_worker, NULL ) != 0) {
+			/* Do it the old way, then */
+			pthread_mutex_unlock( &async_lock );
+			warp_pool_run( objs, num_objs, func, data );
+			return;
+		}
+		async_started = TRUE;
+	}
+	while (async_busy)
+		pthread_cond_wait( &async_cond, &async_lock );
+	async_objs = objs;
+	async_num_objs = num_objs;
+	async_func = func;
+	async_data = data;
+	async_busy = TRUE;
+	pthread_cond_broadcast( &async_cond );
+	pthread_mutex_unlock( &async_lock );
+#else
+	warp_pool_run( objs, num_objs, func, data );
+#endif /* not WITH_THREADED_WARP */
+}
+
+
+/* Waits for the background job (if any) to finish */
+void
+warp_pool_wait( void )
+{
+#ifdef WITH_THREADED_WARP
+	pthread_mutex_lock( &async_lock );
+	while (async_busy)
+		pthread_cond_wait( &async_cond, &async_lock );
+	pthread_mutex_unlock( &async_lock );
+#endif
+}
+
+/* end warp_pool.c */
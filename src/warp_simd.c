@@ -0,0 +1,605 @@
+/* warp_simd.c */
+
+/* Vectorized (AVX2) kernel for the relativistic distortion engine */
+
+/*
+ *  ``The contents of this file are subject to the Mozilla Public License
+ *  Version 1.0 (the "License"); you may not use this file except in
+ *  compliance with the License. You may obtain a copy of the License at
+ *  http://www.mozilla.org/MPL/
+ *
+ *  Software distributed under the License is distributed on an "AS IS"
+ *  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+ *  License for the specific language governing rights and limitations
+ *  under the License.
+ *
+ *  The Original Code is the "Light Speed!" relativistic simulator.
+ *
+ *  The Initial Developer of the Original Code is Daniel Richard G.
+ *  Portions created by the Initial Developer are Copyright (C) 1999
+ *  Daniel Richard G. <skunk@mit.edu> All Rights Reserved.
+ *
+ *  Contributor(s): ______________________________________.''
+ */
+
+
+#include "lightspeed.h"
+
+#ifdef WARP_SIMD_X86
+
+#include <immintrin.h>
+
+/* Everything below is compiled for AVX2, regardless of the -m flags the rest
+ * of the program is built with. None of it may be called unless
+ * warp_simd_supported( ) says so */
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+
+/* Shorthands */
+#define VSET(x)		_mm256_set1_ps( (float)(x) )
+#define VLT(a, b)	_mm256_cmp_ps( (a), (b), _CMP_LT_OQ )
+#define VGT(a, b)	_mm256_cmp_ps( (a), (b), _CMP_GT_OQ )
+/* Lanes of b where mask is set, else lanes of a */
+#define VSEL(a, b, mask)	_mm256_blendv_ps( (a), (b), (mask) )
+
+
+/* Look up 8 values in a [0, LUT_RES] table, clamping the indices */
+static inline __m256
+v_lut( const float *lut, __m256 x )
+{
+	__m256i i;
+
+	x = _mm256_max_ps( VSET(0.0), _mm256_min_ps( x, VSET(LUT_RES) ) );
+	i = _mm256_cvttps_epi32( x );
+
+	return _mm256_i32gather_ps( lut, i, 4 );
+}
+
+
+#if WARP_POLY_APPROX
+/* 1 / sqrt( x ), from the hardware estimate (12 bits) and a Newton step,
+ * which leaves it good to about 2E-7 relative. Lanes with x below 1E-12
+ * (i.e. lengths below 1E-6) give 1 */
+static inline __m256
+v_rsqrt( __m256 x )
+{
+	__m256 r;
+
+	r = _mm256_rsqrt_ps( x );
+	r = _mm256_mul_ps( _mm256_mul_ps( VSET(0.5), r ), _mm256_sub_ps( VSET(3.0), _mm256_mul_ps( x, _mm256_mul_ps( r, r ) ) ) );
+
+	return VSEL(r, VSET(1.0), VLT(x, VSET(1E-12)));
+}
+
+
+/* interp_factor_poly( ) from warp.c, for 8 lanes */
+static inline __m256
+v_interp_factor( __m256 s )
+{
+	__m256 x, x2, k, big;
+
+	big = VGT(s, VSET(1.0));
+	x = VSEL(s, _mm256_div_ps( VSET(1.0), s ), big);
+	x2 = _mm256_mul_ps( x, x );
+	k = _mm256_add_ps( VSET(WARP_ATAN_P3), _mm256_mul_ps( x2, VSET(WARP_ATAN_P4) ) );
+	k = _mm256_add_ps( VSET(WARP_ATAN_P2), _mm256_mul_ps( x2, k ) );
+	k = _mm256_add_ps( VSET(WARP_ATAN_P1), _mm256_mul_ps( x2, k ) );
+	k = _mm256_mul_ps( x, _mm256_add_ps( VSET(WARP_ATAN_P0), _mm256_mul_ps( x2, k ) ) );
+
+	return VSEL(k, _mm256_sub_ps( VSET(1.0), k ), big);
+}
+
+
+/* pow01_poly( ) from warp.c, for 8 lanes */
+static inline __m256
+v_pow01( __m256 x, float k )
+{
+	__m256i i, e;
+	__m256 t, y, p;
+
+	/* log2( x ) = e + log2( 1 + t ) */
+	i = _mm256_castps_si256( _mm256_max_ps( x, VSET(1E-20) ) );
+	e = _mm256_sub_epi32( _mm256_srli_epi32( i, 23 ), _mm256_set1_epi32( 127 ) );
+	i = _mm256_or_si256( _mm256_and_si256( i, _mm256_set1_epi32( 0x007FFFFF ) ), _mm256_set1_epi32( 0x3F800000 ) );
+	t = _mm256_sub_ps( _mm256_castsi256_ps( i ), VSET(1.0) );
+	p = _mm256_add_ps( VSET(WARP_LOG2_P3), _mm256_mul_ps( t, VSET(WARP_LOG2_P4) ) );
+	p = _mm256_add_ps( VSET(WARP_LOG2_P2), _mm256_mul_ps( t, p ) );
+	p = _mm256_add_ps( VSET(WARP_LOG2_P1), _mm256_mul_ps( t, p ) );
+	p = _mm256_add_ps( VSET(WARP_LOG2_P0), _mm256_mul_ps( t, p ) );
+	y = _mm256_add_ps( _mm256_cvtepi32_ps( e ), _mm256_mul_ps( t, p ) );
+	y = _mm256_mul_ps( VSET(k), y );
+
+	/* 2^y = 2^e * 2^t, t in [0, 1) */
+	y = _mm256_max_ps( y, VSET(-126.0) );
+	p = _mm256_floor_ps( y );
+	t = _mm256_sub_ps( y, p );
+	e = _mm256_slli_epi32( _mm256_add_epi32( _mm256_cvttps_epi32( p ), _mm256_set1_epi32( 127 ) ), 23 );
+	p = _mm256_add_ps( VSET(WARP_EXP2_P2), _mm256_mul_ps( t, VSET(WARP_EXP2_P3) ) );
+	p = _mm256_add_ps( VSET(WARP_EXP2_P1), _mm256_mul_ps( t, p ) );
+	p = _mm256_add_ps( VSET(WARP_EXP2_P0), _mm256_mul_ps( t, p ) );
+	p = _mm256_add_ps( VSET(1.0), _mm256_mul_ps( t, p ) );
+
+	return _mm256_mul_ps( p, _mm256_castsi256_ps( e ) );
+}
+#endif /* WARP_POLY_APPROX */
+
+
+/* Doppler shift of a single color component, for an incident light ray.
+ * This is doppler_shift( ) from warp.c rewritten in terms of q = lambda * f
+ * (lambda being the component's wavelength, f the frequency ratio), which
+ * makes every case of its if/else ladder linear in q. All six cases are
+ * evaluated, and the right one selected per lane */
+static inline __m256
+v_doppler_component( float lambda, __m256 f, __m256 r0, __m256 g0, __m256 b0 )
+{
+	__m256 q;
+	__m256 s1, d1, s2, d2;
+	__m256 c, res;
+
+	q = _mm256_mul_ps( VSET(lambda), f );
+
+	/* 0.5b + 0.25g + 0.125r, and related mixes */
+	s1 = _mm256_add_ps( _mm256_mul_ps( VSET(0.5), b0 ), _mm256_add_ps( _mm256_mul_ps( VSET(0.25), g0 ), _mm256_mul_ps( VSET(0.125), r0 ) ) );
+	d1 = _mm256_sub_ps( _mm256_mul_ps( VSET(0.5), b0 ), _mm256_add_ps( _mm256_mul_ps( VSET(0.25), g0 ), _mm256_mul_ps( VSET(0.125), r0 ) ) );
+	s2 = _mm256_add_ps( _mm256_mul_ps( VSET(0.125), b0 ), _mm256_add_ps( _mm256_mul_ps( VSET(0.25), g0 ), _mm256_mul_ps( VSET(0.5), r0 ) ) );
+	d2 = _mm256_sub_ps( _mm256_add_ps( _mm256_mul_ps( VSET(0.125), b0 ), _mm256_mul_ps( VSET(0.25), g0 ) ), _mm256_mul_ps( VSET(0.5), r0 ) );
+
+	/* Beyond infrared */
+	res = _mm256_div_ps( _mm256_mul_ps( s2, VSET(LAMBDA_IR) ), q );
+	/* Red to infrared */
+	c = _mm256_mul_ps( _mm256_sub_ps( q, VSET(LAMBDA_RED) ), VSET(1.0 / (LAMBDA_IR - LAMBDA_RED)) );
+	c = _mm256_add_ps( r0, _mm256_mul_ps( c, d2 ) );
+	res = VSEL(res, c, VLT(q, VSET(LAMBDA_IR)));
+	/* Green to red */
+	c = _mm256_mul_ps( _mm256_sub_ps( q, VSET(LAMBDA_GREEN) ), VSET(1.0 / (LAMBDA_RED - LAMBDA_GREEN)) );
+	c = _mm256_add_ps( g0, _mm256_mul_ps( c, _mm256_sub_ps( r0, g0 ) ) );
+	res = VSEL(res, c, VLT(q, VSET(LAMBDA_RED)));
+	/* Blue to green */
+	c = _mm256_mul_ps( _mm256_sub_ps( q, VSET(LAMBDA_BLUE) ), VSET(1.0 / (LAMBDA_GREEN - LAMBDA_BLUE)) );
+	c = _mm256_add_ps( b0, _mm256_mul_ps( c, _mm256_sub_ps( g0, b0 ) ) );
+	res = VSEL(res, c, VLT(q, VSET(LAMBDA_GREEN)));
+	/* Ultraviolet to blue */
+	c = _mm256_mul_ps( _mm256_sub_ps( q, VSET(LAMBDA_UV) ), VSET(1.0 / (LAMBDA_BLUE - LAMBDA_UV)) );
+	c = _mm256_add_ps( s1, _mm256_mul_ps( c, d1 ) );
+	res = VSEL(res, c, VLT(q, VSET(LAMBDA_BLUE)));
+	/* Beyond ultraviolet */
+	c = _mm256_mul_ps( _mm256_mul_ps( q, VSET(1.0 / LAMBDA_UV) ), s1 );
+	res = VSEL(res, c, VLT(q, VSET(LAMBDA_UV)));
+
+	return res;
+}
+
+
+/* Same thing for reflected light (cf. doppler_shift_ref( )) */
+static inline __m256
+v_doppler_ref_component( float lambda, __m256 f, __m256 r0, __m256 g0, __m256 b0 )
+{
+	__m256 q;
+	__m256 c, res;
+
+	q = _mm256_mul_ps( VSET(lambda), f );
+
+	/* Red or beyond */
+	res = r0;
+	/* Green to red */
+	c = _mm256_mul_ps( _mm256_sub_ps( q, VSET(LAMBDA_GREEN) ), VSET(1.0 / (LAMBDA_RED - LAMBDA_GREEN)) );
+	c = _mm256_add_ps( g0, _mm256_mul_ps( c, _mm256_sub_ps( r0, g0 ) ) );
+	res = VSEL(res, c, VLT(q, VSET(LAMBDA_RED)));
+	/* Blue to green */
+	c = _mm256_mul_ps( _mm256_sub_ps( q, VSET(LAMBDA_BLUE) ), VSET(1.0 / (LAMBDA_GREEN - LAMBDA_BLUE)) );
+	c = _mm256_add_ps( b0, _mm256_mul_ps( c, _mm256_sub_ps( g0, b0 ) ) );
+	res = VSEL(res, c, VLT(q, VSET(LAMBDA_GREEN)));
+	/* Blue or beyond */
+	res = VSEL(res, b0, VLT(q, VSET(LAMBDA_BLUE)));
+
+	return res;
+}
+
+
+/* Lorentz contraction of 8 normals, inv_gamma being 1 / LC_gamma */
+static inline void
+v_contract_normals( __m256 *nx, __m256 *ny, __m256 *nz, __m256 inv_gamma )
+{
+	__m256 len;
+
+	*ny = _mm256_mul_ps( *ny, inv_gamma );
+	*nz = _mm256_mul_ps( *nz, inv_gamma );
+	len = _mm256_mul_ps( *nx, *nx );
+	len = _mm256_add_ps( len, _mm256_mul_ps( *ny, *ny ) );
+	len = _mm256_add_ps( len, _mm256_mul_ps( *nz, *nz ) );
+#if WARP_POLY_APPROX
+	len = v_rsqrt( len );
+	*nx = _mm256_mul_ps( *nx, len );
+	*ny = _mm256_mul_ps( *ny, len );
+	*nz = _mm256_mul_ps( *nz, len );
+#else
+	len = _mm256_sqrt_ps( len );
+	len = VSEL(len, VSET(1.0), VLT(len, VSET(1E-6)));
+	*nx = _mm256_div_ps( *nx, len );
+	*ny = _mm256_div_ps( *ny, len );
+	*nz = _mm256_div_ps( *nz, len );
+#endif
+}
+
+
+/* Optical deformation for 8 vertices, with deform_dist( )'s stable solve
+ * (cf. warp.c), which is good in single precision. x is expected to be
+ * contracted, but not at the "real" x-position yet. Returns the deformed
+ * x-coordinates, and the camera-to-vertex deltas (w.r.t. the "actual"
+ * position) via dx/dy/dz and dist2. Deformation is only done if set in fx */
+static ALWAYS_INLINE __m256
+v_deform_ps( const warp_params *wp, __m256 x, __m256 y, __m256 z, __m256 *dx, __m256 *dy, __m256 *dz, __m256 *dist2, const int fx )
+{
+	__m256 beta, inv_gamma2;
+	__m256 dyz2, root;
+	__m256 num, den, pos;
+
+	/* (the vehicle's x-position may be far larger than it is, so the
+	 * camera is subtracted from that first) */
+	*dx = _mm256_add_ps( x, VSET(wp->real_x - wp->cam_pos.x) );
+	*dy = _mm256_sub_ps( y, VSET(wp->cam_pos.y) );
+	*dz = _mm256_sub_ps( z, VSET(wp->cam_pos.z) );
+	dyz2 = _mm256_add_ps( _mm256_mul_ps( *dy, *dy ), _mm256_mul_ps( *dz, *dz ) );
+	*dist2 = _mm256_add_ps( _mm256_mul_ps( *dx, *dx ), dyz2 );
+	if (!(fx & WARP_FX_DEFORMATION))
+		return _mm256_add_ps( x, VSET(wp->real_x) );
+
+	/* v*t = beta * dist2 / (root + beta*dx)	(dx > 0)
+	 *     = beta * (root - beta*dx) / inv_gamma2	(otherwise) */
+	beta = VSET(wp->OD_v_over_C);
+	inv_gamma2 = VSET(wp->OD_inv_gamma2);
+	root = _mm256_sqrt_ps( _mm256_add_ps( _mm256_mul_ps( *dx, *dx ), _mm256_mul_ps( inv_gamma2, dyz2 ) ) );
+	pos = VGT(*dx, _mm256_setzero_ps( ));
+	num = VSEL(_mm256_sub_ps( root, _mm256_mul_ps( beta, *dx ) ), *dist2, pos);
+	den = VSEL(inv_gamma2, _mm256_add_ps( root, _mm256_mul_ps( beta, *dx ) ), pos);
+	num = _mm256_div_ps( _mm256_mul_ps( beta, num ), den );
+
+	return _mm256_add_ps( VSET(wp->cam_pos.x), _mm256_sub_ps( *dx, num ) );
+}
+
+
+/* Returns TRUE if this CPU can run the AVX2 kernel */
+int
+warp_simd_supported( void )
+{
+	__builtin_cpu_init( );
+	return __builtin_cpu_supports( "avx2" );
+}
+
+
+/* AVX2 counterpart of warp_kernel_scalar_fx( ), processing WARP_SIMD_WIDTH
+ * (8) vertices at a time from SoA geometry streams laid out like the
+ * object's soa0 (which is what soa is, unless it is the contracted copy),
+ * for each of num_wps cameras. v0 should be a multiple of
+ * WARP_SIMD_WIDTH for aligned loads. Notable differences from the scalar
+ * kernel: normals are renormalized with a reciprocal square root estimate
+ * and a Newton step (a true square root without WARP_POLY_APPROX), and the
+ * Doppler shift ladders are evaluated branch-free.
+ * Results agree to within float rounding. As with the scalar kernel, only
+ * the effects in (constant) fx are compiled in */
+static ALWAYS_INLINE void
+warp_kernel_avx2_fx( ogl_object *obj, const float *soa, ogl_point **outs, int v0, int v1, const warp_params *wps, int num_wps, const int fx )
+{
+	const warp_params *wp0 = &wps[0];
+	const warp_params *wp;
+	float lanes[9][WARP_SIMD_WIDTH] __attribute__((aligned(32)));
+	const float *sx, *sy, *sz;
+	const float *snx, *sny, *snz;
+	ogl_point *pnt;
+	__m256 x, y, z, nx, ny, nz;
+	__m256 cx, cnx, cny, cnz;
+	__m256 r, g, b;
+	__m256 fdx, fdy, fdz;
+	__m256 cos_alpha_c;
+	__m256 inv_gamma;
+	__m256 len, k, f, in_ray;
+	__m256 intensity, rot_mask;
+#if !WARP_POLY_APPROX
+	__m256 k1, k2;
+#endif
+	__m256 one, tiny;
+	__m256 base_r, base_g, base_b;
+	__m256 dist2;
+	int stride;
+	int vn, c, l, n;
+
+	stride = obj->soa_stride;
+	sx = soa;
+	sy = &sx[stride];
+	sz = &sy[stride];
+	snx = &sz[stride];
+	sny = &snx[stride];
+	snz = &sny[stride];
+
+	one = VSET(1.0);
+	tiny = VSET(1E-6);
+	inv_gamma = VSET(1.0 / wp0->LC_gamma);
+	fdx = fdy = fdz = _mm256_setzero_ps( );
+	cos_alpha_c = _mm256_setzero_ps( );
+
+	if (!(fx & WARP_FX_COLOR)) {
+		/* Color is the same throughout (cf. warp_kernel_scalar_fx( )) */
+		base_r = VSET(MIN(1.0, obj->color0.r));
+		base_g = VSET(MIN(1.0, obj->color0.g));
+		base_b = VSET(MIN(1.0, obj->color0.b));
+		if (wp0->dgamma_correct) {
+#if WARP_POLY_APPROX
+			base_r = v_pow01( base_r, wp0->dgamma_exp );
+			base_g = v_pow01( base_g, wp0->dgamma_exp );
+			base_b = v_pow01( base_b, wp0->dgamma_exp );
+#else
+			base_r = v_lut( wp0->dgamma_lut, _mm256_mul_ps( base_r, VSET(LUT_RES) ) );
+			base_g = v_lut( wp0->dgamma_lut, _mm256_mul_ps( base_g, VSET(LUT_RES) ) );
+			base_b = v_lut( wp0->dgamma_lut, _mm256_mul_ps( base_b, VSET(LUT_RES) ) );
+#endif
+		}
+	}
+	else
+		base_r = base_g = base_b = one;
+
+	for (vn = v0; vn < v1; vn += WARP_SIMD_WIDTH) {
+		x = _mm256_loadu_ps( &sx[vn] );
+		y = _mm256_loadu_ps( &sy[vn] );
+		z = _mm256_loadu_ps( &sz[vn] );
+		nx = _mm256_loadu_ps( &snx[vn] );
+		ny = _mm256_loadu_ps( &sny[vn] );
+		nz = _mm256_loadu_ps( &snz[vn] );
+
+		/**** RELATIVISTIC GEOMETRY TRANSFORMS ****/
+
+		/** Lorentz contraction (of the normals) **/
+		if (fx & WARP_FX_CONTRACTION)
+			v_contract_normals( &nx, &ny, &nz, inv_gamma );
+
+		/* Contraction of x (the move to the "real" x-position
+		 * is left to v_deform_ps( ), if it gets called) */
+		if (fx & WARP_FX_CONTRACTION)
+			x = _mm256_div_ps( x, VSET(wp0->LC_gamma) );
+		if (!(fx & (WARP_FX_DEFORMATION | WARP_FX_COLOR)))
+			x = _mm256_add_ps( x, VSET(wp0->real_x) );
+
+		/* The rest depends on the camera position, and is done
+		 * for each camera in turn while the vertices are at hand */
+		for (c = 0; c < num_wps; c++) {
+			wp = &wps[c];
+			cx = x;
+			cnx = nx;
+			cny = ny;
+			cnz = nz;
+
+			if (fx & (WARP_FX_DEFORMATION | WARP_FX_COLOR)) {
+				/** Optical deformation **/
+				cx = v_deform_ps( wp, x, y, z, &fdx, &fdy, &fdz, &dist2, fx );
+
+				if (fx & WARP_FX_COLOR) {
+					/* cos_alpha_c = - dx / sqrt( dist2 ), or 0 if too close */
+					cos_alpha_c = _mm256_div_ps( fdx, _mm256_sqrt_ps( dist2 ) );
+					cos_alpha_c = _mm256_and_ps( cos_alpha_c, VGT(dist2, tiny) );
+					cos_alpha_c = _mm256_sub_ps( _mm256_setzero_ps( ), cos_alpha_c );
+				}
+			}
+
+			/**** RELATIVISTIC COLOR/INTENSITY TRANSFORMS ****/
+
+			if (fx & WARP_FX_COLOR) {
+				/** Headlight effect (incoming light), cos_alpha_n == nx **/
+				if (fx & WARP_FX_HEADLIGHT) {
+					k = _mm256_add_ps( one, _mm256_mul_ps( VSET(wp->HE_v_over_C), cnx ) );
+					in_ray = _mm256_mul_ps( _mm256_mul_ps( k, k ), VSET(wp->HE_gamma) );
+				}
+				else
+					in_ray = one;
+
+				/** Doppler frequency shift (incoming light) **/
+				if (fx & WARP_FX_DOPPLER) {
+					f = _mm256_add_ps( one, _mm256_mul_ps( VSET(wp->DS_v_over_C), cnx ) );
+					f = _mm256_mul_ps( f, VSET(wp->DS_gamma) );
+					r = v_doppler_component( LAMBDA_RED, f, in_ray, in_ray, in_ray );
+					g = v_doppler_component( LAMBDA_GREEN, f, in_ray, in_ray, in_ray );
+					b = v_doppler_component( LAMBDA_BLUE, f, in_ray, in_ray, in_ray );
+				}
+				else
+					r = g = b = in_ray;
+
+				/* Illuminative color interaction */
+				r = _mm256_mul_ps( VSET(obj->color0.r), _mm256_mul_ps( r, r ) );
+				g = _mm256_mul_ps( VSET(obj->color0.g), _mm256_mul_ps( g, g ) );
+				b = _mm256_mul_ps( VSET(obj->color0.b), _mm256_mul_ps( b, b ) );
+
+				/** Doppler frequency shift (outgoing light) **/
+				if (fx & WARP_FX_DOPPLER) {
+					f = _mm256_add_ps( one, _mm256_mul_ps( VSET(wp->DS_v_over_C), cos_alpha_c ) );
+					f = _mm256_mul_ps( f, VSET(wp->DS_gamma) );
+					k = v_doppler_ref_component( LAMBDA_RED, f, r, g, b );
+					in_ray = v_doppler_ref_component( LAMBDA_GREEN, f, r, g, b );
+					b = v_doppler_ref_component( LAMBDA_BLUE, f, r, g, b );
+					r = k;
+					g = in_ray;
+				}
+
+				/** Headlight effect (outgoing light) **/
+				if (fx & WARP_FX_HEADLIGHT) {
+					k = _mm256_add_ps( one, _mm256_mul_ps( VSET(wp->HE_v_over_C), cos_alpha_c ) );
+					k = _mm256_mul_ps( _mm256_mul_ps( k, k ), VSET(wp->HE_gamma) );
+					r = _mm256_mul_ps( r, k );
+					g = _mm256_mul_ps( g, k );
+					b = _mm256_mul_ps( b, k );
+				}
+
+				/* If intensity exceeds I(1,1,1), rotate normal toward camera */
+				intensity = _mm256_mul_ps( r, VSET(RED_STRENGTH) );
+				intensity = _mm256_add_ps( intensity, _mm256_mul_ps( g, VSET(GREEN_STRENGTH) ) );
+				intensity = _mm256_add_ps( intensity, _mm256_mul_ps( b, VSET(BLUE_STRENGTH) ) );
+				rot_mask = VGT(intensity, one);
+				if (_mm256_movemask_ps( rot_mask ) != 0) {
+					__m256 rnx, rny, rnz;
+
+					/* Normal interpolation factor, as in the
+					 * scalar kernel */
+					k = _mm256_sub_ps( intensity, one );
+#if WARP_POLY_APPROX
+					k = v_interp_factor( k );
+#else
+					k1 = v_lut( wp->interp_lut1, _mm256_mul_ps( k, VSET(LUT_RES) ) );
+					k2 = v_lut( wp->interp_lut2, _mm256_div_ps( VSET(LUT_RES), _mm256_max_ps( k, tiny ) ) );
+					k = VSEL(k2, k1, _mm256_cmp_ps( intensity, VSET(2.0), _CMP_LE_OQ ));
+#endif
+					/* Interpolate between normal vector and
+					 * vertex-to-camera vector */
+					rnx = _mm256_sub_ps( cnx, _mm256_mul_ps( k, _mm256_add_ps( fdx, cnx ) ) );
+					rny = _mm256_sub_ps( cny, _mm256_mul_ps( k, _mm256_add_ps( fdy, cny ) ) );
+					rnz = _mm256_sub_ps( cnz, _mm256_mul_ps( k, _mm256_add_ps( fdz, cnz ) ) );
+					/* Renormalize */
+					len = _mm256_mul_ps( rnx, rnx );
+					len = _mm256_add_ps( len, _mm256_mul_ps( rny, rny ) );
+					len = _mm256_add_ps( len, _mm256_mul_ps( rnz, rnz ) );
+#if WARP_POLY_APPROX
+					len = v_rsqrt( len );
+					cnx = VSEL(cnx, _mm256_mul_ps( rnx, len ), rot_mask);
+					cny = VSEL(cny, _mm256_mul_ps( rny, len ), rot_mask);
+					cnz = VSEL(cnz, _mm256_mul_ps( rnz, len ), rot_mask);
+#else
+					len = _mm256_sqrt_ps( len );
+					len = VSEL(len, one, VLT(len, tiny));
+					cnx = VSEL(cnx, _mm256_div_ps( rnx, len ), rot_mask);
+					cny = VSEL(cny, _mm256_div_ps( rny, len ), rot_mask);
+					cnz = VSEL(cnz, _mm256_div_ps( rnz, len ), rot_mask);
+#endif
+				}
+
+				/* Clamp color components to legal range */
+				r = _mm256_min_ps( r, one );
+				g = _mm256_min_ps( g, one );
+				b = _mm256_min_ps( b, one );
+
+				/* Display gamma correction */
+				if (wp->dgamma_correct) {
+#if WARP_POLY_APPROX
+					r = v_pow01( r, wp->dgamma_exp );
+					g = v_pow01( g, wp->dgamma_exp );
+					b = v_pow01( b, wp->dgamma_exp );
+#else
+					r = v_lut( wp->dgamma_lut, _mm256_mul_ps( r, VSET(LUT_RES) ) );
+					g = v_lut( wp->dgamma_lut, _mm256_mul_ps( g, VSET(LUT_RES) ) );
+					b = v_lut( wp->dgamma_lut, _mm256_mul_ps( b, VSET(LUT_RES) ) );
+#endif
+				}
+			}
+			else {
+				r = base_r;
+				g = base_g;
+				b = base_b;
+			}
+
+			/* Scatter into the interleaved arrays */
+			_mm256_store_ps( lanes[0], r );
+			_mm256_store_ps( lanes[1], g );
+			_mm256_store_ps( lanes[2], b );
+			_mm256_store_ps( lanes[3], cnx );
+			_mm256_store_ps( lanes[4], cny );
+			_mm256_store_ps( lanes[5], cnz );
+			_mm256_store_ps( lanes[6], cx );
+			_mm256_store_ps( lanes[7], y );
+			_mm256_store_ps( lanes[8], z );
+			n = MIN(WARP_SIMD_WIDTH, v1 - vn);
+			for (l = 0; l < n; l++) {
+				pnt = &outs[c][vn + l];
+				pnt->r = lanes[0][l];
+				pnt->g = lanes[1][l];
+				pnt->b = lanes[2][l];
+				pnt->nx = lanes[3][l];
+				pnt->ny = lanes[4][l];
+				pnt->nz = lanes[5][l];
+				pnt->x = lanes[6][l];
+				pnt->y = lanes[7][l];
+				pnt->z = lanes[8][l];
+			}
+		}
+	}
+}
+
+
+/* Kernel variants, one per combination of effects (cf. warp.c) */
+#define WARP_KERNEL_AVX2_VARIANT(fx) \
+static void \
+warp_kernel_avx2_##fx( ogl_object *obj, const float *soa, ogl_point **outs, int v0, int v1, const warp_params *wps, int num_wps ) \
+{ \
+	warp_kernel_avx2_fx( obj, soa, outs, v0, v1, wps, num_wps, fx ); \
+}
+WARP_KERNEL_AVX2_VARIANT(0)
+WARP_KERNEL_AVX2_VARIANT(1)
+WARP_KERNEL_AVX2_VARIANT(2)
+WARP_KERNEL_AVX2_VARIANT(3)
+WARP_KERNEL_AVX2_VARIANT(4)
+WARP_KERNEL_AVX2_VARIANT(5)
+WARP_KERNEL_AVX2_VARIANT(6)
+WARP_KERNEL_AVX2_VARIANT(7)
+WARP_KERNEL_AVX2_VARIANT(8)
+WARP_KERNEL_AVX2_VARIANT(9)
+WARP_KERNEL_AVX2_VARIANT(10)
+WARP_KERNEL_AVX2_VARIANT(11)
+WARP_KERNEL_AVX2_VARIANT(12)
+WARP_KERNEL_AVX2_VARIANT(13)
+WARP_KERNEL_AVX2_VARIANT(14)
+WARP_KERNEL_AVX2_VARIANT(15)
+
+/* ...indexed by warp_params.effects */
+static void (* const avx2_kernels[WARP_FX_ALL + 1])( ogl_object *obj, const float *soa, ogl_point **outs, int v0, int v1, const warp_params *wps, int num_wps ) = {
+	warp_kernel_avx2_0, warp_kernel_avx2_1, warp_kernel_avx2_2, warp_kernel_avx2_3,
+	warp_kernel_avx2_4, warp_kernel_avx2_5, warp_kernel_avx2_6, warp_kernel_avx2_7,
+	warp_kernel_avx2_8, warp_kernel_avx2_9, warp_kernel_avx2_10, warp_kernel_avx2_11,
+	warp_kernel_avx2_12, warp_kernel_avx2_13, warp_kernel_avx2_14, warp_kernel_avx2_15
+};
+
+
+/* AVX2 kernel, specialized for the effects in wp->effects */
+void
+warp_kernel_avx2( ogl_object *obj, ogl_point *out, int v0, int v1, const warp_params *wp )
+{
+	avx2_kernels[wp->effects]( obj, obj->soa0, &out, v0, v1, wp, 1 );
+}
+
+
+/* Same, for several cameras at once (cf. warp_kernel_scalar_fx( )), with
+ * the given effects and source streams (cf. warp_range( )) */
+void
+warp_kernel_avx2_multi( ogl_object *obj, const float *soa, ogl_point **outs, int v0, int v1, const warp_params *wps, int num_wps, int effects )
+{
+	avx2_kernels[effects]( obj, soa, outs, v0, v1, wps, num_wps );
+}
+
+
+/* Fills in streams [v0, v1) of the object's contracted geometry (soa_lc)
+ * from its soa0, for the given LC_gamma. Same math as in the kernel */
+void
+warp_contract_avx2( ogl_object *obj, int v0, int v1, double LC_gamma )
+{
+	const float *src = obj->soa0;
+	float *dst = obj->soa_lc;
+	__m256 inv_gamma;
+	__m256 nx, ny, nz;
+	int stride;
+	int vn;
+
+	stride = obj->soa_stride;
+	inv_gamma = VSET(1.0 / LC_gamma);
+	for (vn = v0; vn < v1; vn += WARP_SIMD_WIDTH) {
+		_mm256_storeu_ps( &dst[vn], _mm256_div_ps( _mm256_loadu_ps( &src[vn] ), VSET(LC_gamma) ) );
+		_mm256_storeu_ps( &dst[stride + vn], _mm256_loadu_ps( &src[stride + vn] ) );
+		_mm256_storeu_ps( &dst[2 * stride + vn], _mm256_loadu_ps( &src[2 * stride + vn] ) );
+		nx = _mm256_loadu_ps( &src[3 * stride + vn] );
+		ny = _mm256_loadu_ps( &src[4 * stride + vn] );
+		nz = _mm256_loadu_ps( &src[5 * stride + vn] );
+		v_contract_normals( &nx, &ny, &nz, inv_gamma );
+		_mm256_storeu_ps( &dst[3 * stride + vn], nx );
+		_mm256_storeu_ps( &dst[4 * stride + vn], ny );
+		_mm256_storeu_ps( &dst[5 * stride + vn], nz );
+	}
+}
+
+#pragma GCC pop_options
+
+#endif /* WARP_SIMD_X86 */
+
+/* end warp_simd.c */